@@ -0,0 +1,29 @@
+// This example streams two ADC channels at full rate over USB as COBS framed
+// binary packets. Use extras/tools/frame_decoder.py on the host to decode them.
+
+#include <Arduino_AdvancedAnalog.h>
+
+AdvancedADC adc(A0, A1);
+// Frames are compressed losslessly with RiceCodec, use AN_FRAME_RAW16 to send raw samples.
+FrameWriter writer(Serial, 8192, AN_FRAME_RICE);
+
+void setup() {
+    Serial.begin(2000000);
+    while (!Serial);
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    if (!adc.begin(AN_RESOLUTION_16, 100000, 256, 32)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+}
+
+void loop() {
+    if (adc.available()) {
+        SampleBuffer buf = adc.read();
+        // Encode the buffer, frames are sent in large batches.
+        writer.write(buf);
+        // Release the buffer to return it to the pool.
+        buf.release();
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * GIGA R1 - ADC Dual Core
+ * The M7 core runs the ADC and DAC, and the M4 core processes the samples: upload this
+ * sketch to both cores. Buffers are allocated from SRAM4, which both cores can access,
+ * and only buffer descriptors are passed between the cores.
+ * NOTE: The shared memory range must not be used by either core's firmware (e.g. RPC).
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SHARED_MEM_BASE     (0x38008000)
+#define SHARED_MEM_SIZE     (1024)
+// A non-cacheable region's size must be a power of two, and its base aligned to its size.
+#define POOL_MEM_BASE       (0x3800C000)
+#define POOL_MEM_SIZE       (16 * 1024)
+
+CoreLink link((void *) SHARED_MEM_BASE, SHARED_MEM_SIZE);
+
+#ifdef CORE_CM7
+
+AdvancedADC adc(A0);
+AdvancedDAC dac(A12);
+
+void setup() {
+    Serial.begin(115200);
+
+    // Allocate the ADC buffers from shared, non-cacheable memory.
+    DMAMemory::region(AN_MEM_USER, POOL_MEM_BASE, POOL_MEM_SIZE);
+    adc.memory(AN_MEM_USER | AN_MEM_NOCACHE);
+
+    if (!link.begin(8)) {
+        Serial.println("Failed to start core link!");
+        while (1);
+    }
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    if (!adc.begin(AN_RESOLUTION_12, 16000, 256, 16)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+
+    // The DAC plays the ADC's buffers, which are queued by the DAC, so its
+    // queue must be as deep as the ADC's.
+    if (!dac.begin(AN_RESOLUTION_12, 16000, 256, 16)) {
+        Serial.println("Failed to start DAC!");
+        while (1);
+    }
+
+    // Boot the M4 core.
+    bootM4();
+}
+
+void loop() {
+    if (adc.available()) {
+        // Send the buffer to the M4 core, or drop it if the M4 is too slow.
+        SampleBuffer buf = adc.read();
+        if (!link.send(buf)) {
+            buf.release();
+        }
+    }
+
+    if (link.available()) {
+        // Play the buffers processed by the M4 core.
+        dac.write(link.receive());
+    }
+}
+
+#else
+
+void setup() {
+    if (!link.attach(5000)) {
+        while (1);
+    }
+}
+
+void loop() {
+    // Invert the signal in place, and send it back.
+    SampleBuffer buf = link.receive();
+    for (size_t i=0; i<buf.size(); i++) {
+        buf[i] = 4095 - buf[i];
+    }
+    link.send(buf);
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * GIGA R1 - ADC History
+ * Keeps the last 2 seconds of samples in a circular history, and dumps them when a
+ * fault is detected (here, when the signal crosses a threshold). The snapshot doesn't
+ * stop sampling or copy any samples.
+ * In history mode buffers aren't delivered to read(), so the fault check polls peek(),
+ * and scans every new sample of the buffer being filled. Only the last few samples of
+ * each buffer, still in the DMA FIFO when the buffer completes, aren't checked, so any
+ * fault lasting more than 8 samples (0.5 ms) is caught.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SAMPLE_RATE     (16000)
+#define N_SAMPLES       (1000)
+#define N_HISTORY       (2 * SAMPLE_RATE / N_SAMPLES)
+
+AdvancedADC adc(A0);
+DMABuffer<Sample> *snapshot[N_HISTORY];
+Sample window[N_SAMPLES];
+size_t checked = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    // The pool holds one history and one snapshot, plus the DMA buffers.
+    if (!adc.begin(AN_RESOLUTION_16, SAMPLE_RATE, N_SAMPLES, 2 * N_HISTORY + 3)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+
+    if (!adc.history(N_HISTORY)) {
+        Serial.println("Failed to enable history mode!");
+        while (1);
+    }
+}
+
+void loop() {
+    // Copy the samples converted so far in the buffer being filled, and check
+    // the ones that weren't checked yet. Fewer samples than already checked means
+    // the DMA moved on to the next buffer.
+    size_t n = adc.peek(window, N_SAMPLES, false);
+    if (n < checked) {
+        checked = 0;
+    }
+    for (size_t i=checked; i<n; i++) {
+        if (window[i] > 60000) {
+            dump();
+            n = i + 1;
+            break;
+        }
+    }
+    checked = n;
+}
+
+void dump() {
+    // Freeze the history, and print it oldest buffer first.
+    size_t n = adc.snapshot(snapshot, N_HISTORY);
+    Serial.print("Fault! History buffers: ");
+    Serial.println(n);
+    for (size_t i=0; i<n; i++) {
+        DMABuffer<Sample> &buf = *snapshot[i];
+        Serial.print("ts: ");
+        Serial.print(buf.timestamp());
+        Serial.print(" first: ");
+        Serial.println(buf[0]);
+        buf.release();
+    }
+}
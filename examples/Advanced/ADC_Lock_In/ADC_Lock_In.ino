@@ -0,0 +1,61 @@
+/*
+ * GIGA R1 - ADC Lock-In
+ * Outputs a 1 kHz reference on A12/DAC0 to excite a sensor, and measures the amplitude
+ * and phase of the sensor's response on A0, even if it's far below the noise. The ADC
+ * is triggered by the DAC's timer, so the lock-in's reference, taken from the same DDS
+ * as the DAC output, is aligned with the stimulus by sample index.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SAMPLE_RATE     (48000)
+#define N_SAMPLES       (256)
+#define N_BUFFERS       (8)
+
+AdvancedADC adc(A0);
+AdvancedDAC dac(A12);
+DDS dds;
+LockIn lockin;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    if (!dac.begin(AN_RESOLUTION_12, SAMPLE_RATE, N_SAMPLES, N_BUFFERS)) {
+        Serial.println("Failed to start the DAC!");
+        while (1);
+    }
+
+    // Arm the ADC on the DAC's timer: both start with the first DAC buffers.
+    adc.trigger(AN_TRIGGER_DAC);
+    if (!adc.begin(AN_RESOLUTION_16, SAMPLE_RATE, N_SAMPLES, N_BUFFERS)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+
+    // The lock-in's reference starts at the DDS phase of the first DAC sample.
+    // Output the amplitude and phase 10 times per second, with a 2 Hz bandwidth.
+    dds.begin(dac.rate(), 1000);
+    lockin.begin(dds, dac.rate() / 10, 2.0f);
+}
+
+void loop() {
+    if (dac.available()) {
+        SampleBuffer buf = dac.dequeue();
+        dds.generate(buf, 1000, 2048);
+        dac.write(buf);
+    }
+
+    if (adc.available()) {
+        SampleBuffer buf = adc.read();
+        lockin.compute(buf);
+        buf.release();
+    }
+
+    while (lockin.available()) {
+        LockInSample out = lockin.read();
+        Serial.print(out.amplitude[0], 3);
+        Serial.print(" ");
+        Serial.println(out.phase[0], 2);
+    }
+}
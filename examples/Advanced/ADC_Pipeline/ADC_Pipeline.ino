@@ -0,0 +1,61 @@
+/*
+ * GIGA R1 - ADC Pipeline
+ * Filters the signal on A0 and plays it on DAC1, with each processing stage running
+ * in its own thread. Buffers are passed between stages without copying, and the time
+ * spent in each stage is printed every second.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+AdvancedADC adc(A0);
+AdvancedDAC dac(A12);
+
+// Low-pass filter, then 16-bit to 12-bit conversion for the DAC.
+FilterStage filter(3);
+ConvertStage convert(-4);
+Pipeline pipeline(4);
+
+const char *names[] = {"filter", "convert", "dac"};
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    if (!adc.begin(AN_RESOLUTION_16, 16000, 128, 16)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+
+    // The DAC plays the ADC's buffers, which are queued by the DAC, so its
+    // queue must be as deep as the ADC's.
+    if (!dac.begin(AN_RESOLUTION_12, 16000, 128, 16)) {
+        Serial.println("Failed to start DAC!");
+        while (1);
+    }
+
+    pipeline.source(adc);
+    pipeline.stage(filter);
+    pipeline.stage(convert);
+    pipeline.sink(dac);
+    if (!pipeline.begin(AN_PIPELINE_THREADED)) {
+        Serial.println("Failed to start pipeline!");
+        while (1);
+    }
+}
+
+void loop() {
+    delay(1000);
+    for (size_t i=0; i<pipeline.stages(); i++) {
+        PipelineStats stats = pipeline.stats(i);
+        Serial.print(names[i]);
+        Serial.print(": buffers: ");
+        Serial.print(stats.buffers);
+        Serial.print(" busy us: ");
+        Serial.print(stats.busy_us);
+        Serial.print(" max us: ");
+        Serial.print(stats.max_us);
+        Serial.print(" stalls: ");
+        Serial.println(stats.stalls);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * GIGA R1 - ADC Ratiometric
+ * Samples a pin together with the internal voltage reference and temperature sensor,
+ * and corrects the pin's readings for the actual supply voltage in every buffer, so
+ * they don't drift with the supply. The internal channels are only connected to ADC3,
+ * so the pin must be on ADC3 as well.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SAMPLE_RATE     (10000)
+#define N_SAMPLES       (500)
+
+// The internal channels come first, to decide the ADC.
+AdvancedADC adc(AN_ADC_VREFINT, AN_ADC_TEMP, A4);
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    if (!adc.begin(AN_RESOLUTION_16, SAMPLE_RATE, N_SAMPLES, 8)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+
+    if (!adc.correction(true)) {
+        Serial.println("Failed to enable the supply correction!");
+        while (1);
+    }
+}
+
+void loop() {
+    if (adc.available()) {
+        SampleBuffer buf = adc.read();
+        // Average the pin's samples, the third channel.
+        uint32_t sum = 0;
+        for (size_t i=2; i<buf.size(); i+=buf.channels()) {
+            sum += buf[i];
+        }
+        float volts = 3.3f * sum / (N_SAMPLES * 65535.0f);
+        buf.release();
+
+        Serial.print("VDDA: ");
+        Serial.print(adc.vdda(), 3);
+        Serial.print(" V, temperature: ");
+        Serial.print(adc.temperature(), 1);
+        Serial.print(" C, A4: ");
+        Serial.print(volts, 4);
+        Serial.println(" V");
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * GIGA R1 - ADC Recorder
+ * Records two ADC channels to a wav file on a USB drive for 10 seconds. Completed buffers
+ * are coalesced into large sector-aligned writes, and the write latency is reported at the end.
+ * In order for this sketch to work you need to rename 'USB_DRIVE' to the name of your USB stick drive.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#include <Arduino_USBHostMbed5.h>
+
+#include <DigitalOut.h>
+#include <FATFileSystem.h>
+
+AdvancedADC adc(A0, A1);
+SampleRecorder recorder(32768);
+
+USBHostMSD msd;
+mbed::FATFileSystem usb("USB_DRIVE");
+
+FILE * file = nullptr;
+uint32_t start_millis = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    // Enable power for HOST USB connector.
+    pinMode(PA_15, OUTPUT);
+    digitalWrite(PA_15, HIGH);
+
+    Serial.println("Please connect a USB stick to the GIGA's USB port ...");
+    while (!msd.connect()) delay(100);
+
+    if (usb.mount(&msd)) {
+        Serial.println("Error mounting USB device");
+        while (1);
+    }
+
+    // Use AN_RECORDER_CHUNKED for a seekable, timestamped capture instead.
+    file = fopen("/USB_DRIVE/CAPTURE.wav", "wb");
+    if (file == nullptr || !recorder.begin(file, AN_RECORDER_WAV, 48000, 2, AN_RESOLUTION_16)) {
+        Serial.println("Failed to start recording!");
+        while (1);
+    }
+
+    // Resolution, sample rate, number of samples per channel, queue depth.
+    if (!adc.begin(AN_RESOLUTION_16, 48000, 512, 32)) {
+        Serial.println("Failed to start analog acquisition!");
+        while (1);
+    }
+    start_millis = millis();
+}
+
+void loop() {
+    if (file == nullptr) {
+        return;
+    }
+
+    if (adc.available()) {
+        SampleBuffer buf = adc.read();
+        recorder.write(buf);
+        buf.release();
+    }
+
+    if ((millis() - start_millis) > 10000) {
+        adc.stop();
+        recorder.end();
+        fclose(file);
+        file = nullptr;
+
+        const RecorderStats &stats = recorder.stats();
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Recorded %lu frames, %lu writes, latency min/avg/max: %lu/%lu/%lu us",
+                (uint32_t) recorder.recorded(), stats.writes, stats.min_us,
+                stats.total_us / (stats.writes ? stats.writes : 1), stats.max_us);
+        Serial.println(msg);
+    }
+}
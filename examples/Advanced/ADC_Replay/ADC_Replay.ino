@@ -0,0 +1,75 @@
+/*
+ * GIGA R1 - ADC Replay
+ * Replays a capture recorded with SampleRecorder (see the ADC_Recorder example) through the
+ * same available()/read()/release() interface as AdvancedADC, and measures the time spent
+ * processing each buffer. Replaying the same file always produces the same input.
+ * In order for this sketch to work you need to rename 'USB_DRIVE' to the name of your USB stick drive.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#include <Arduino_USBHostMbed5.h>
+
+#include <DigitalOut.h>
+#include <FATFileSystem.h>
+
+SampleReplay replay;
+
+USBHostMSD msd;
+mbed::FATFileSystem usb("USB_DRIVE");
+
+FILE * file = nullptr;
+uint32_t n_buffers = 0;
+uint32_t total_us = 0;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    // Enable power for HOST USB connector.
+    pinMode(PA_15, OUTPUT);
+    digitalWrite(PA_15, HIGH);
+
+    Serial.println("Please connect a USB stick to the GIGA's USB port ...");
+    while (!msd.connect()) delay(100);
+
+    if (usb.mount(&msd)) {
+        Serial.println("Error mounting USB device");
+        while (1);
+    }
+
+    // File, number of samples per channel, queue depth, pace.
+    file = fopen("/USB_DRIVE/CAPTURE.wav", "rb");
+    if (file == nullptr || !replay.begin(file, 512, 8, AN_REPLAY_FAST)) {
+        Serial.println("Failed to start replay!");
+        while (1);
+    }
+}
+
+void loop() {
+    if (replay.available()) {
+        SampleBuffer buf = replay.read();
+
+        // Process the buffer: find the peak-to-peak amplitude of the first channel.
+        uint32_t start = micros();
+        Sample lo = 0xFFFF, hi = 0;
+        for (size_t i=0; i<buf.size(); i+=buf.channels()) {
+            lo = min(lo, buf[i]);
+            hi = max(hi, buf[i]);
+        }
+        total_us += micros() - start;
+        n_buffers++;
+
+        buf.release();
+    } else if (file && replay.eof()) {
+        replay.stop();
+        fclose(file);
+        file = nullptr;
+
+        Serial.print("Processed buffers: ");
+        Serial.print(n_buffers);
+        Serial.print(", average time per buffer: ");
+        Serial.print(total_us / (n_buffers ? n_buffers : 1));
+        Serial.println(" us");
+    }
+}
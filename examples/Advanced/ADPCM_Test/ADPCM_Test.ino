@@ -0,0 +1,73 @@
+/*
+ * GIGA R1 - ADPCM Test
+ * Checks the IMA ADPCM codec against a reference vector: a 36 byte WAV IMA ADPCM block
+ * and the PCM samples it decodes to. The vector was generated with the reference IMA
+ * ADPCM implementation (Python's audioop.lin2adpcm/adpcm2lin, starting from the first
+ * sample with step index 0), with the nibbles swapped to the WAV order.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define N_SAMPLES       (65)
+#define BLOCK_SIZE      (36)
+
+// Input: a two-tone signal, with a full scale step at samples 40-41.
+static const int16_t PCM_IN[N_SAMPLES] = {
+    0, 15067, 19714, 15252, 12003, 15691, 20044, 14876, -473, -15232,
+    -19364, -14824, -12031, -16141, -20354, -14659, 946, 15370, 18996, 14409,
+    12087, 16598, 20642, 14418, -1415, -15482, -18611, -14008, -12171, -17062,
+    -20906, -14153, 1879, 15565, 18210, 13623, 12282, 17531, 21148, 13865,
+    -32768, 32767, -17795, -13255, -12421, -18003, -21364, -13556, 2785, 15650,
+    17367, 12905, 12586, 18477, 21555, 13226, -3224, -15650, -16927, -12574,
+    -12777, -18951, -21720, -12876, 3653
+};
+
+// The encoded block: header (first sample, step index, reserved), then 32 bytes of codes.
+static const uint8_t BLOCK[BLOCK_SIZE] = {
+    0x00, 0x00, 0x00, 0x00, 0x77, 0x77, 0x77, 0xF7, 0xFF, 0x01, 0x99, 0x62,
+    0x13, 0x99, 0x21, 0xEB, 0x9B, 0x01, 0x99, 0x72, 0x13, 0x89, 0x11, 0xFB,
+    0xE7, 0x81, 0x88, 0x21, 0x83, 0x88, 0x02, 0xEB, 0x8A, 0x00, 0x8A, 0x73
+};
+
+// The decoded block.
+static const int16_t PCM_OUT[N_SAMPLES] = {
+    0, 11, 41, 104, 240, 533, 1164, 2521, -389, -6625,
+    -19997, -14264, -12527, -17264, -21570, -15044, 381, 15096, 20829, 15618,
+    10881, 15187, 21713, 13408, -615, -13992, -19203, -14466, -13031, -16946,
+    -20505, -15112, -404, 14311, 20044, 14833, 13254, 17560, 21475, 13170,
+    -3010, 31677, -21568, -9282, -13006, -16391, -19468, -11074, 1644, 17831,
+    15729, 13818, 12081, 19977, 21412, 12276, -3149, -13660, -15571, -13834,
+    -12255, -19433, -20738, -12433, 3747
+};
+
+uint8_t block[BLOCK_SIZE];
+int16_t pcm[N_SAMPLES];
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    IMAADPCM encoder;
+    size_t size = encoder.encode_block(PCM_IN, N_SAMPLES, block);
+    bool enc_ok = (size == BLOCK_SIZE) && !memcmp(block, BLOCK, BLOCK_SIZE);
+
+    IMAADPCM decoder;
+    size_t n = decoder.decode_block(BLOCK, BLOCK_SIZE, pcm, N_SAMPLES);
+    bool dec_ok = (n == IMAADPCM::block_samples(BLOCK_SIZE)) && (n == N_SAMPLES)
+               && !memcmp(pcm, PCM_OUT, sizeof(PCM_OUT));
+
+    // The decoder must not write more samples than requested.
+    pcm[10] = 0x5A5A;
+    n = decoder.decode_block(BLOCK, BLOCK_SIZE, pcm, 10);
+    bool cap_ok = (n == 10) && (pcm[10] == 0x5A5A) && !memcmp(pcm, PCM_OUT, 10 * sizeof(int16_t));
+
+    Serial.print("encode_block: ");
+    Serial.println(enc_ok ? "PASS" : "FAIL");
+    Serial.print("decode_block: ");
+    Serial.println(dec_ok ? "PASS" : "FAIL");
+    Serial.print("decode_block capacity: ");
+    Serial.println(cap_ok ? "PASS" : "FAIL");
+}
+
+void loop() {
+}
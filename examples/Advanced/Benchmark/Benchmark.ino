@@ -0,0 +1,328 @@
+/*
+ * Buffer pipeline benchmark
+ *
+ * Measures the cost of the Queue and DMABufferPool operations, the latency from a
+ * simulated transfer complete interrupt to the consumer, the maximum sustainable
+ * sample rate for a range of n_samples/n_buffers/channels, and the per-buffer cost of
+ * the ISR path and of the CPU's accesses for cacheable and non-cacheable pools, and
+ * the Rice encoding rate. Results are printed as one JSON object per line, so they can
+ * be collected and compared between library versions:
+ *
+ *   {"bench":"queue","op":"push_pop","iterations":100000,"ns_per_op":...}
+ *
+ * The benchmarks only use the buffer classes and SyntheticADC, no ADC/DAC hardware.
+ */
+
+#include <Arduino_AdvancedAnalog.h>
+#include <mbed.h>
+
+#define N_ITERATIONS    (100000)
+#define N_LATENCY       (2000)
+#define N_HISTOGRAM     (16)
+
+static void print_header() {
+    Serial.print("{\"suite\":\"AdvancedAnalog\",\"build\":\"");
+    Serial.print(__DATE__ " " __TIME__);
+    Serial.print("\",\"cpu_hz\":");
+    Serial.print(SystemCoreClock);
+    Serial.println("}");
+}
+
+static void bench_queue() {
+    Queue<DMABuffer<Sample>*> queue(64);
+    DMABuffer<Sample> buf;
+
+    uint32_t start = micros();
+    for (size_t i=0; i<N_ITERATIONS; i++) {
+        queue.push(&buf);
+        queue.pop();
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.print("{\"bench\":\"queue\",\"op\":\"push_pop\",\"iterations\":");
+    Serial.print(N_ITERATIONS);
+    Serial.print(",\"ns_per_op\":");
+    Serial.print((elapsed * 1000.0f) / N_ITERATIONS, 1);
+    Serial.println("}");
+}
+
+// Full buffer life cycles: allocate (ISR), invalidate and enqueue (ISR),
+// dequeue (consumer), a minimal per-sample workload (consumer), release.
+// All n_buffers are in flight: the ready queue is filled, then drained, as
+// when the consumer falls behind, so the queues run at their full depth.
+static float pool_cycle_us(size_t n_samples, size_t n_channels, size_t n_buffers, size_t iterations) {
+    DMABufferPool<Sample> pool(n_samples, n_channels, n_buffers);
+    volatile uint32_t sink = 0;
+    size_t n_rounds = (iterations + n_buffers - 1) / n_buffers;
+
+    uint32_t start = micros();
+    for (size_t i=0; i<n_rounds; i++) {
+        while (pool.writable()) {
+            DMABuffer<Sample> *buf = pool.allocate();
+            buf->invalidate();
+            pool.enqueue(buf);
+        }
+
+        while (pool.readable()) {
+            DMABuffer<Sample> *buf = pool.dequeue();
+            uint32_t sum = 0;
+            Sample *data = buf->data();
+            for (size_t j=0; j<buf->size(); j++) {
+                sum += data[j];
+            }
+            sink += sum;
+            buf->release();
+        }
+    }
+    return (float) (micros() - start) / (n_rounds * n_buffers);
+}
+
+static void bench_pool() {
+    const size_t n_samples_lut[] = {32, 128, 512, 2048};
+    const size_t n_buffers_lut[] = {4, 32};
+    const size_t n_channels_lut[] = {1, 3, 5};
+
+    for (auto n_samples : n_samples_lut) {
+        for (auto n_buffers : n_buffers_lut) {
+            for (auto n_channels : n_channels_lut) {
+                size_t iterations = (N_ITERATIONS * 32) / (n_samples * n_channels);
+                float us = pool_cycle_us(n_samples, n_channels, n_buffers, iterations);
+                // A buffer holds n_samples per channel, and must be consumed
+                // before the next one completes.
+                float max_rate = (us > 0.0f) ? (n_samples * 1000000.0f / us) : 0.0f;
+
+                Serial.print("{\"bench\":\"pool\",\"n_samples\":");
+                Serial.print(n_samples);
+                Serial.print(",\"n_buffers\":");
+                Serial.print(n_buffers);
+                Serial.print(",\"channels\":");
+                Serial.print(n_channels);
+                Serial.print(",\"us_per_buffer\":");
+                Serial.print(us, 3);
+                Serial.print(",\"max_sample_rate\":");
+                Serial.print(max_rate, 0);
+                Serial.println("}");
+            }
+        }
+    }
+}
+
+// Simulated ISR: completes a buffer from a timer interrupt, timestamped in us.
+static DMABufferPool<Sample> *lat_pool = nullptr;
+static volatile uint32_t lat_dropped = 0;
+
+static void lat_isr() {
+    if (lat_pool->writable()) {
+        DMABuffer<Sample> *buf = lat_pool->allocate();
+        buf->timestamp(micros());
+        lat_pool->enqueue(buf);
+    } else {
+        lat_dropped++;
+    }
+}
+
+static void bench_latency(uint32_t period_us, uint32_t work_us) {
+    uint32_t histogram[N_HISTOGRAM] = {0};
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    mbed::Ticker ticker;
+
+    lat_pool = new DMABufferPool<Sample>(64, 1, 16);
+    lat_dropped = 0;
+    ticker.attach(&lat_isr, std::chrono::microseconds(period_us));
+
+    for (size_t n=0; n<N_LATENCY; ) {
+        if (lat_pool->readable()) {
+            DMABuffer<Sample> *buf = lat_pool->dequeue();
+            uint32_t latency = micros() - buf->timestamp();
+            buf->release();
+
+            // Power of two histogram buckets, in us.
+            size_t bucket = 0;
+            while (bucket < (N_HISTOGRAM - 1) && (1UL << bucket) <= latency) {
+                bucket++;
+            }
+            histogram[bucket]++;
+            max_us = max(max_us, latency);
+            total_us += latency;
+            n++;
+
+            // Simulated processing.
+            delayMicroseconds(work_us);
+        }
+    }
+    ticker.detach();
+    delete lat_pool;
+    lat_pool = nullptr;
+
+    Serial.print("{\"bench\":\"latency\",\"period_us\":");
+    Serial.print(period_us);
+    Serial.print(",\"work_us\":");
+    Serial.print(work_us);
+    Serial.print(",\"avg_us\":");
+    Serial.print((float) total_us / N_LATENCY, 2);
+    Serial.print(",\"max_us\":");
+    Serial.print(max_us);
+    Serial.print(",\"dropped\":");
+    Serial.print(lat_dropped);
+    Serial.print(",\"histogram_log2_us\":[");
+    for (size_t i=0; i<N_HISTOGRAM; i++) {
+        Serial.print(histogram[i]);
+        Serial.print((i < N_HISTOGRAM - 1) ? "," : "]");
+    }
+    Serial.println("}");
+}
+
+// Cacheable vs non-cacheable pools. For a non-cacheable pool, invalidate() and
+// flush() do nothing, while the CPU's accesses to the samples are uncached, so
+// what's measured is each side of a buffer's life cycle: the ADC ISR path
+// (allocate, invalidate, enqueue), the consumer reading the samples that were
+// just written by the DMA, and a producer writing the samples for the DAC
+// (fill, flush).
+static void bench_cache() {
+    const size_t n_samples_lut[] = {1024, 4096, 16384};
+    const uint32_t region_lut[] = {AN_MEM_HEAP, AN_MEM_SRAM1 | AN_MEM_NOCACHE};
+    const size_t n_iterations = 100;
+    volatile uint32_t sink = 0;
+
+    for (auto region : region_lut) {
+        for (auto n_samples : n_samples_lut) {
+            DMABufferPool<Sample> pool(n_samples, 1, 2, region);
+            if (!pool) {
+                continue;
+            }
+
+            uint32_t start = micros();
+            for (size_t i=0; i<n_iterations; i++) {
+                DMABuffer<Sample> *buf = pool.allocate();
+                buf->invalidate();
+                pool.enqueue(buf);
+                pool.dequeue()->release();
+            }
+            float isr_us = (float) (micros() - start) / n_iterations;
+
+            // Invalidating before each pass discards the cached lines, as if the
+            // DMA had just written the buffer, so the reads go to memory.
+            DMABuffer<Sample> *buf = pool.allocate();
+            Sample *data = buf->data();
+            uint32_t read_total = 0;
+            for (size_t i=0; i<n_iterations; i++) {
+                buf->invalidate();
+                start = micros();
+                uint32_t sum = 0;
+                for (size_t j=0; j<buf->size(); j++) {
+                    sum += data[j];
+                }
+                read_total += micros() - start;
+                sink += sum;
+            }
+
+            start = micros();
+            for (size_t i=0; i<n_iterations; i++) {
+                for (size_t j=0; j<buf->size(); j++) {
+                    data[j] = i + j;
+                }
+                buf->flush();
+            }
+            float write_us = (float) (micros() - start) / n_iterations;
+            buf->release();
+
+            Serial.print("{\"bench\":\"cache\",\"nocache\":");
+            Serial.print((region & AN_MEM_NOCACHE) ? "true" : "false");
+            Serial.print(",\"n_samples\":");
+            Serial.print(n_samples);
+            Serial.print(",\"isr_us\":");
+            Serial.print(isr_us, 2);
+            Serial.print(",\"read_us\":");
+            Serial.print((float) read_total / n_iterations, 2);
+            Serial.print(",\"write_us\":");
+            Serial.print(write_us, 2);
+            Serial.println("}");
+        }
+    }
+}
+
+// Rice encoding of ADC-like data: a slow sine with a few LSBs of noise, which
+// compresses to less than half. The rate is in samples (all channels) per second,
+// which must stay above the ADC's aggregate rate for encoding to keep up.
+static void bench_rice() {
+    const size_t n_samples_lut[] = {256, 1024};
+    const size_t n_channels_lut[] = {1, 2};
+    const size_t n_iterations = 100;
+    static Sample src[2048];
+    static uint8_t dst[4096 + AN_RICE_HEADER_SIZE + 64];
+
+    uint32_t lfsr = 0xACE1u;
+    for (size_t i=0; i<AN_ARRAY_SIZE(src); i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        src[i] = 2048 + (int) (1500.0f * sinf(i * 0.01f)) + (lfsr & 0x7);
+    }
+
+    for (auto n_samples : n_samples_lut) {
+        for (auto n_channels : n_channels_lut) {
+            if (RiceCodec::max_size(n_samples, n_channels) > sizeof(dst)) {
+                continue;
+            }
+            size_t size = 0;
+            uint32_t start = micros();
+            for (size_t i=0; i<n_iterations; i++) {
+                size = RiceCodec::encode(src, n_samples, n_channels, dst, sizeof(dst));
+            }
+            float us = (float) (micros() - start) / n_iterations;
+
+            Serial.print("{\"bench\":\"rice\",\"n_samples\":");
+            Serial.print(n_samples);
+            Serial.print(",\"channels\":");
+            Serial.print(n_channels);
+            Serial.print(",\"us_per_buffer\":");
+            Serial.print(us, 2);
+            Serial.print(",\"ratio\":");
+            Serial.print((size > 0) ? (n_samples * n_channels * sizeof(Sample) / (float) size) : 0.0f, 2);
+            Serial.print(",\"samples_per_second\":");
+            Serial.print((us > 0.0f) ? (n_samples * n_channels * 1000000.0f / us) : 0.0f, 0);
+            Serial.println("}");
+        }
+    }
+}
+
+static void bench_synthetic() {
+    // End-to-end: simulated DMA completions, consumed as fast as possible.
+    const size_t n_samples_lut[] = {64, 512};
+    for (auto n_samples : n_samples_lut) {
+        SyntheticADC adc(2);
+        adc.begin(AN_RESOLUTION_12, 1000000, n_samples, 8, AN_SYNTHETIC_FAST);
+        size_t n_buffers = 0;
+        uint32_t start = micros();
+        while ((micros() - start) < 200000) {
+            adc.read().release();
+            n_buffers++;
+        }
+        uint32_t elapsed = micros() - start;
+        adc.stop();
+
+        Serial.print("{\"bench\":\"synthetic\",\"n_samples\":");
+        Serial.print(n_samples);
+        Serial.print(",\"channels\":2,\"samples_per_second\":");
+        Serial.print((n_buffers * n_samples * 1000000.0f) / elapsed, 0);
+        Serial.println("}");
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    print_header();
+    bench_queue();
+    bench_pool();
+    bench_latency(1000, 0);
+    bench_latency(1000, 500);
+    bench_latency(250, 200);
+    bench_synthetic();
+    bench_cache();
+    bench_rice();
+    Serial.println("{\"done\":true}");
+}
+
+void loop() {
+}
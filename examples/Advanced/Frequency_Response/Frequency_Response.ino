@@ -0,0 +1,65 @@
+/*
+ * GIGA R1 - Frequency Response
+ * Measures the gain and phase of an analog circuit from 100 Hz to 20 kHz. The stimulus
+ * is output on A12/DAC0, which must also be connected to A0 as a reference, and the
+ * circuit's output is connected to A1. The first sweep, with A1 connected directly to
+ * A12, is stored as a calibration, which removes the response of the converters.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SAMPLE_RATE     (64000)
+#define N_SAMPLES       (512)
+#define N_BUFFERS       (8)
+#define N_POINTS        (32)
+
+AdvancedADC adc(A0, A1);
+AdvancedDAC dac(A12);
+ResponseAnalyzer analyzer;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    if (!analyzer.begin(adc, dac, AN_RESOLUTION_16, SAMPLE_RATE, N_SAMPLES, N_BUFFERS)) {
+        Serial.println("Failed to start the analyzer!");
+        while (1);
+    }
+    analyzer.amplitude(0.8f);
+
+    Serial.println("Connect A1 to A12, and send any character to calibrate.");
+    while (!Serial.available());
+    Serial.read();
+    run();
+    analyzer.calibrate();
+
+    Serial.println("Connect the circuit, and send any character to measure.");
+}
+
+void loop() {
+    if (Serial.available()) {
+        Serial.read();
+        run();
+        for (size_t i=0; i<analyzer.points(); i++) {
+            // Channel 1 is the circuit's output.
+            Serial.print(analyzer.frequency(i));
+            Serial.print(" Hz: ");
+            Serial.print(20.0f * log10f(analyzer.gain(i, 1)));
+            Serial.print(" dB ");
+            Serial.print(analyzer.phase(i, 1));
+            Serial.println(" deg");
+        }
+    }
+}
+
+void run() {
+    // Stepped sweep: 4 buffers to settle, then 8 buffers measured per point.
+    if (!analyzer.sweep(100, 20000, N_POINTS, AN_SWEEP_STEPPED, 4, 8)) {
+        Serial.println("Failed to start the sweep!");
+        return;
+    }
+    while (!analyzer.poll());
+    if (analyzer.points() < N_POINTS) {
+        Serial.println("Sweep aborted, samples were dropped!");
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * GIGA R1 - Goertzel Test
+ * Checks that GoertzelBank stays in tune for low tones, such as mains harmonics, at high
+ * sample rates: a 50 Hz filter at 48 kHz must be tuned within 0.1 Hz, and measure the
+ * amplitude of a 50 Hz tone spanning a whole number of periods within 1%.
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#define SAMPLE_RATE     (48000)
+#define N_SAMPLES       (4800)      // 5 periods of 50 Hz.
+#define AMPLITUDE       (1000.0f)
+
+static Sample samples[N_SAMPLES];
+GoertzelBank goertzel;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+    float tones[] = {50.0f, 150.0f};
+    goertzel.begin(SAMPLE_RATE, 2, tones);
+
+    for (size_t i=0; i<N_SAMPLES; i++) {
+        samples[i] = lroundf(32768.0f + AMPLITUDE * sinf(2.0f * PI * 50.0f * i / SAMPLE_RATE));
+    }
+    DMABuffer<Sample> buf(nullptr, N_SAMPLES, 1, samples);
+    // The DC offset is estimated from the previous buffer.
+    goertzel.compute(buf);
+    goertzel.compute(buf);
+
+    float tuned = goertzel.frequency(0);
+    float amplitude = goertzel.magnitude(0, 0);
+    bool tune_ok = fabsf(tuned - 50.0f) < 0.1f;
+    bool amp_ok = fabsf(amplitude - AMPLITUDE) < (AMPLITUDE / 100);
+    bool rej_ok = goertzel.magnitude(0, 1) < (AMPLITUDE / 100);
+
+    Serial.print("50 Hz tuned to ");
+    Serial.print(tuned, 4);
+    Serial.print(" Hz: ");
+    Serial.println(tune_ok ? "PASS" : "FAIL");
+    Serial.print("50 Hz amplitude ");
+    Serial.print(amplitude);
+    Serial.print(": ");
+    Serial.println(amp_ok ? "PASS" : "FAIL");
+    Serial.print("150 Hz rejection: ");
+    Serial.println(rej_ok ? "PASS" : "FAIL");
+}
+
+void loop() {
+}
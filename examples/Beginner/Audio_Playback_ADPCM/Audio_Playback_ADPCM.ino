@@ -0,0 +1,132 @@
+/*
+ * GIGA R1 - Audio Playback (IMA ADPCM)
+ * Plays an IMA ADPCM compressed wav file via 12-Bit DAC output by reading from a USB drive.
+ * ADPCM files are 4x smaller than 16-bit PCM, so they need 4x less storage I/O and memory.
+ * In order for this sketch to work you need to rename 'USB_DRIVE' to the name of your USB stick drive.
+ * A compatible mono file can be created from AUDIO_SAMPLE.wav with:
+ *   sox AUDIO_SAMPLE.wav -e ima-adpcm AUDIO_SAMPLE_ADPCM.wav
+*/
+
+#include <Arduino_AdvancedAnalog.h>
+
+#include <Arduino_USBHostMbed5.h>
+
+#include <DigitalOut.h>
+#include <FATFileSystem.h>
+
+AdvancedDAC dac1(A12);
+
+USBHostMSD msd;
+mbed::FATFileSystem usb("USB_DRIVE");
+
+FILE * file = nullptr;
+IMAADPCM adpcm;
+size_t block_size = 0;
+uint8_t * block = nullptr;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  /* Enable power for HOST USB connector. */
+  pinMode(PA_15, OUTPUT);
+  digitalWrite(PA_15, HIGH);
+
+  Serial.println("Please connect a USB stick to the GIGA's USB port ...");
+  while (!msd.connect()) delay(100);
+
+  Serial.println("Mounting USB device ...");
+  int const rc_mount = usb.mount(&msd);
+  if (rc_mount)
+  {
+    Serial.print("Error mounting USB device ");
+    Serial.println(rc_mount);
+    return;
+  }
+
+  Serial.println("Opening audio file ...");
+  file = fopen("/USB_DRIVE/AUDIO_SAMPLE_ADPCM.wav", "rb");
+  if (file == nullptr)
+  {
+    Serial.print("Error opening audio file: ");
+    Serial.println(strerror(errno));
+    return;
+  }
+
+  struct wav_header_t
+  {
+    char chunkID[4];
+    uint32_t chunkSize;
+    char format[4];
+    char subchunk1ID[4];
+    uint32_t subchunk1Size;
+    uint16_t audioFormat;
+    uint16_t numChannels;
+    uint32_t sampleRate;
+    uint32_t byteRate;
+    uint16_t blockAlign;
+    uint16_t bitsPerSample;
+  };
+
+  wav_header_t header;
+  fread(&header, sizeof(header), 1, file);
+
+  if (header.audioFormat != AN_ADPCM_WAVE_FORMAT || header.numChannels != 1)
+  {
+    Serial.println("Not a mono IMA ADPCM wav file!");
+    return;
+  }
+
+  /* Skip the rest of the fmt chunk, and find the data chunk. */
+  fseek(file, 20 + header.subchunk1Size, SEEK_SET);
+  struct chunk_t
+  {
+    char ID[4];
+    uint32_t size;
+  };
+
+  chunk_t chunk;
+  while (fread(&chunk, sizeof(chunk), 1, file) == 1 && memcmp(chunk.ID, "data", 4) != 0)
+  {
+    fseek(file, chunk.size, SEEK_CUR);
+  }
+
+  /* Each DAC buffer holds exactly one decoded ADPCM block. */
+  block_size = header.blockAlign;
+  block = new uint8_t[block_size];
+  size_t n_samples = IMAADPCM::block_samples(block_size);
+
+  char msg[64] = {0};
+  snprintf(msg, sizeof(msg), "Sample rate = %lu, block size = %u", header.sampleRate, block_size);
+  Serial.println(msg);
+
+  /* Configure the advanced DAC. */
+  if (!dac1.begin(AN_RESOLUTION_12, header.sampleRate, n_samples, 16))
+  {
+    Serial.println("Failed to start DAC1 !");
+    return;
+  }
+}
+
+void loop()
+{
+  if (block && dac1.available() && !feof(file))
+  {
+    /* Read one block from file. */
+    size_t size = fread(block, 1, block_size, file);
+
+    /* Get a free buffer for writing. */
+    SampleBuffer buf = dac1.dequeue();
+
+    /* Decode the block straight into the DAC buffer. */
+    size_t n = adpcm.decode_block(block, size, buf, AN_RESOLUTION_12);
+    for (size_t i = n; i < buf.size(); i++)
+    {
+      buf[i] = 0x800;
+    }
+
+    /* Write the buffer to DAC. */
+    dac1.write(buf);
+  }
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Arduino_AdvancedAnalog library.
+# Copyright (c) 2023 Arduino SA. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# Usage:
+#   aarc_reader.py capture.aarc [--csv out.csv] [--seek FRAME]
+
+"""Reads chunked captures written by SampleRecorder (AN_RECORDER_CHUNKED)."""
+
+import argparse
+import struct
+import sys
+
+SECTOR = 512
+FILE_HEADER = struct.Struct("<4s9I")
+DATA_HEADER = struct.Struct("<4s6I")
+DISCONT = 1 << 0
+
+
+class Capture:
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        (magic, self.version, self.sample_rate, self.channels, self.resolution, self.block_size,
+         self.index_interval, self.index_size, frames_lo, frames_hi) = FILE_HEADER.unpack(self.file.read(FILE_HEADER.size))
+        if magic != b"AARC":
+            raise ValueError("not a chunked capture")
+        self.frames = frames_lo | (frames_hi << 32)
+        self.frames_per_block = (self.block_size - DATA_HEADER.size) // (self.channels * 2)
+
+    def chunk_offset(self, k):
+        return SECTOR + k * self.block_size + (k // self.index_interval) * self.index_size
+
+    def read_chunk(self, k):
+        """Returns (first frame, timestamp, flags, samples) of data chunk k, or None."""
+        self.file.seek(self.chunk_offset(k))
+        data = self.file.read(self.block_size)
+        if len(data) < DATA_HEADER.size:
+            return None
+        magic, _, lo, hi, ts, flags, size = DATA_HEADER.unpack_from(data)
+        if magic != b"DATA":
+            return None
+        samples = struct.unpack_from("<%dH" % (size // 2), data, DATA_HEADER.size)
+        return lo | (hi << 32), ts, flags, samples
+
+    def seek(self, frame):
+        """Returns the index of the data chunk holding the given frame, in O(1)."""
+        return frame // self.frames_per_block
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("source", help="capture file")
+    parser.add_argument("--csv", help="write samples to a CSV file")
+    parser.add_argument("--seek", type=int, default=0, help="first frame to read")
+    args = parser.parse_args()
+
+    cap = Capture(args.source)
+    print("rate=%d channels=%d resolution=%d frames=%d" % (cap.sample_rate, cap.channels, cap.resolution, cap.frames),
+          file=sys.stderr)
+    csv = open(args.csv, "w") if args.csv else None
+    k = cap.seek(args.seek)
+    n_chunks = n_discont = 0
+    while True:
+        chunk = cap.read_chunk(k)
+        if chunk is None:
+            break
+        first, ts, flags, samples = chunk
+        n_chunks += 1
+        n_discont += bool(flags & DISCONT)
+        if csv:
+            for i in range(0, len(samples), cap.channels):
+                frame = first + i // cap.channels
+                if frame >= args.seek:
+                    csv.write("%d,%d,%s\n" % (frame, ts, ",".join(map(str, samples[i:i + cap.channels]))))
+        k += 1
+    if csv:
+        csv.close()
+    print("chunks=%d discontinuities=%d" % (n_chunks, n_discont), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Arduino_AdvancedAnalog library.
+# Copyright (c) 2023 Arduino SA. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# Host-side decoder for the COBS framed binary stream written by FrameWriter.
+#
+# Usage:
+#   frame_decoder.py /dev/ttyACM0 [--csv out.csv]    (requires pyserial)
+#   frame_decoder.py capture.bin [--csv out.csv]
+
+"""Decodes FrameWriter binary streams from a serial port or a capture file."""
+
+import argparse
+import struct
+import sys
+import zlib
+
+import rice_decoder
+
+FRAME_VERSION = 1
+FRAME_HEADER = struct.Struct("<BBBBIII")
+FRAME_DISCONT = 1 << 0
+FRAME_INTRLVD = 1 << 1
+FRAME_RAW16 = 0
+FRAME_RICE = 1
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            raise ValueError("invalid COBS code")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Frame:
+    def __init__(self, channels, flags, encoding, seq, timestamp, payload):
+        self.channels = channels
+        self.flags = flags
+        self.encoding = encoding
+        self.seq = seq
+        self.timestamp = timestamp
+        self.payload = payload
+
+    def samples(self):
+        """Returns the payload as a list of per-channel sample lists."""
+        if self.encoding == FRAME_RAW16:
+            data = struct.unpack("<%dH" % (len(self.payload) // 2), self.payload)
+        elif self.encoding == FRAME_RICE:
+            _, data, _ = rice_decoder.decode(self.payload)
+        else:
+            raise ValueError("unsupported encoding %d" % self.encoding)
+        return [list(data[c::self.channels]) for c in range(self.channels)]
+
+
+def parse_frame(raw):
+    """Decodes and validates one frame (without the 0x00 delimiter)."""
+    data = cobs_decode(raw)
+    if len(data) < FRAME_HEADER.size + 4:
+        raise ValueError("short frame")
+    crc, = struct.unpack("<I", data[-4:])
+    if zlib.crc32(data[:-4]) & 0xFFFFFFFF != crc:
+        raise ValueError("CRC mismatch")
+    version, channels, flags, encoding, seq, ts, size = FRAME_HEADER.unpack_from(data)
+    if version != FRAME_VERSION:
+        raise ValueError("unsupported version %d" % version)
+    payload = data[FRAME_HEADER.size:-4]
+    if len(payload) != size:
+        raise ValueError("bad payload length")
+    return Frame(channels, flags, encoding, seq, ts, payload)
+
+
+class FrameDecoder:
+    """Incremental decoder, feed it arbitrary chunks of the byte stream."""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.last_seq = None
+        self.errors = 0
+        self.dropped = 0
+
+    def feed(self, chunk):
+        self.pending += chunk
+        while True:
+            end = self.pending.find(b"\x00")
+            if end < 0:
+                break
+            raw = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if not raw:
+                continue
+            try:
+                frame = parse_frame(raw)
+            except ValueError:
+                self.errors += 1
+                continue
+            if self.last_seq is not None:
+                self.dropped += (frame.seq - self.last_seq - 1) & 0xFFFFFFFF
+            self.last_seq = frame.seq
+            yield frame
+
+
+def open_source(path):
+    try:
+        import serial
+        if not path.endswith(".bin"):
+            return serial.Serial(path, timeout=1)
+    except ImportError:
+        pass
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("source", help="serial port or binary capture file")
+    parser.add_argument("--csv", help="write samples to a CSV file")
+    parser.add_argument("--frames", type=int, default=0, help="stop after N frames")
+    args = parser.parse_args()
+
+    src = open_source(args.source)
+    csv = open(args.csv, "w") if args.csv else None
+    decoder = FrameDecoder()
+    n_frames = n_samples = 0
+    try:
+        while True:
+            chunk = src.read(65536)
+            if not chunk:
+                if not hasattr(src, "baudrate"):
+                    break
+                continue
+            for frame in decoder.feed(chunk):
+                n_frames += 1
+                channels = frame.samples()
+                n_samples += len(channels[0]) * frame.channels
+                if csv:
+                    for row in zip(*channels):
+                        csv.write("%d,%s\n" % (frame.timestamp, ",".join(map(str, row))))
+                if args.frames and n_frames >= args.frames:
+                    raise KeyboardInterrupt
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if csv:
+            csv.close()
+    print("frames=%d samples=%d dropped=%d errors=%d" % (n_frames, n_samples, decoder.dropped, decoder.errors),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
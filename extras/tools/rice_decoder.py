@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Arduino_AdvancedAnalog library.
+# Copyright (c) 2023 Arduino SA. All rights reserved.
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2.1 of the License, or (at your option) any later version.
+#
+# Usage:
+#   rice_decoder.py block.bin [--raw out.raw]
+
+"""Decodes blocks encoded with RiceCodec into interleaved 16-bit samples."""
+
+import argparse
+import struct
+import sys
+
+RICE_HEADER = struct.Struct("<BBI")
+RICE_ESCAPE = 15
+
+
+class BitReader:
+    """Reads MSB-first bits from a buffer, a byte at a time."""
+
+    def __init__(self, data):
+        self.data = memoryview(data)
+        self.pos = 0        # Next byte to load.
+        self.acc = 0        # Loaded bits not consumed yet.
+        self.n = 0          # Number of bits in acc.
+
+    def load(self):
+        if self.pos >= len(self.data):
+            raise ValueError("truncated block")
+        self.acc = (self.acc << 8) | self.data[self.pos]
+        self.pos += 1
+        self.n += 8
+
+    def get(self, n):
+        while self.n < n:
+            self.load()
+        self.n -= n
+        value = self.acc >> self.n
+        self.acc &= (1 << self.n) - 1
+        return value
+
+    def unary(self):
+        # Count zeros up to the terminating one.
+        q = 0
+        while self.acc == 0:
+            q += self.n
+            self.n = self.acc = 0
+            self.load()
+        length = self.acc.bit_length()
+        q += self.n - length
+        self.n = length - 1
+        self.acc &= (1 << self.n) - 1
+        return q
+
+    def used(self):
+        # Bytes consumed, including a partly consumed last byte.
+        return self.pos
+
+
+def decode(block):
+    """Returns (channels, samples, bytes used) where samples are interleaved."""
+    channels, part_log2, n_samples = RICE_HEADER.unpack_from(block)
+    if channels == 0 or part_log2 > 16:
+        raise ValueError("invalid block header")
+    part_size = 1 << part_log2
+    br = BitReader(memoryview(block)[RICE_HEADER.size:])
+    out = [0] * (n_samples * channels)
+    for c in range(channels):
+        prev = out[c] = br.get(16)
+        for start in range(1, n_samples, part_size):
+            k = br.get(4)
+            for i in range(start, min(start + part_size, n_samples)):
+                if k == RICE_ESCAPE:
+                    u = br.get(16)
+                else:
+                    u = (br.unary() << k) | br.get(k)
+                prev = out[i * channels + c] = (prev + ((u >> 1) ^ -(u & 1))) & 0xFFFF
+    return channels, out, RICE_HEADER.size + br.used()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("source", help="file containing one or more encoded blocks")
+    parser.add_argument("--raw", help="write decoded samples as raw little-endian 16-bit")
+    args = parser.parse_args()
+
+    # Blocks are decoded from a view of the file, without copying the rest of it.
+    data = memoryview(open(args.source, "rb").read())
+    raw = open(args.raw, "wb") if args.raw else None
+    offset = n_blocks = n_samples = 0
+    while offset < len(data):
+        channels, samples, used = decode(data[offset:])
+        offset += used
+        n_blocks += 1
+        n_samples += len(samples)
+        if raw:
+            raw.write(struct.pack("<%dH" % len(samples), *samples))
+    if raw:
+        raw.close()
+    print("blocks=%d samples=%d ratio=%.2f" % (n_blocks, n_samples, n_samples * 2 / max(len(data), 1)),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,239 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ADPCM.h"
+
+static const int8_t ADPCM_INDEX_LUT[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const uint16_t ADPCM_STEP_LUT[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const uint8_t ADC_BITS_LUT[] = {
+    8, 10, 12, 14, 16,
+};
+
+static inline int16_t adc_to_pcm(Sample s, uint32_t shift) {
+    return (int16_t) ((int32_t) (s << shift) - 32768);
+}
+
+static inline Sample pcm_to_dac(int16_t s, uint32_t shift) {
+    return (Sample) ((uint16_t) (s + 32768) >> shift);
+}
+
+static inline uint32_t dac_shift(uint32_t resolution) {
+    // NOTE: The DAC uses 12-bit alignment for 10-bit resolution.
+    return (resolution == AN_RESOLUTION_8) ? 8 : 4;
+}
+
+uint8_t IMAADPCM::encode(int16_t sample) {
+    int32_t step = ADPCM_STEP_LUT[index];
+    int32_t diff = sample - predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    // Successive approximation of diff / step, tracking the
+    // reconstructed difference exactly as the decoder will.
+    int32_t vpdiff = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    predictor += (code & 8) ? -vpdiff : vpdiff;
+    if (predictor > 32767) {
+        predictor = 32767;
+    } else if (predictor < -32768) {
+        predictor = -32768;
+    }
+
+    index += ADPCM_INDEX_LUT[code];
+    if (index < 0) {
+        index = 0;
+    } else if (index > 88) {
+        index = 88;
+    }
+    return code;
+}
+
+int16_t IMAADPCM::decode(uint8_t code) {
+    int32_t step = ADPCM_STEP_LUT[index];
+    int32_t vpdiff = step >> 3;
+
+    if (code & 4) {
+        vpdiff += step;
+    }
+    if (code & 2) {
+        vpdiff += step >> 1;
+    }
+    if (code & 1) {
+        vpdiff += step >> 2;
+    }
+
+    predictor += (code & 8) ? -vpdiff : vpdiff;
+    if (predictor > 32767) {
+        predictor = 32767;
+    } else if (predictor < -32768) {
+        predictor = -32768;
+    }
+
+    index += ADPCM_INDEX_LUT[code & 0x0F];
+    if (index < 0) {
+        index = 0;
+    } else if (index > 88) {
+        index = 88;
+    }
+    return predictor;
+}
+
+size_t IMAADPCM::encode(const int16_t *src, size_t n, uint8_t *dst) {
+    for (size_t i=0; i<n/2; i++) {
+        uint8_t lo = encode(src[i * 2 + 0]);
+        uint8_t hi = encode(src[i * 2 + 1]);
+        dst[i] = lo | (hi << 4);
+    }
+    return n / 2;
+}
+
+size_t IMAADPCM::decode(const uint8_t *src, size_t n, int16_t *dst) {
+    for (size_t i=0; i<n/2; i++) {
+        dst[i * 2 + 0] = decode(src[i] & 0x0F);
+        dst[i * 2 + 1] = decode(src[i] >> 4);
+    }
+    return n / 2;
+}
+
+size_t IMAADPCM::encode(SampleBuffer buf, uint8_t *dst, uint32_t resolution, size_t channel) {
+    if (resolution >= AN_ARRAY_SIZE(ADC_BITS_LUT) || channel >= buf.channels()) {
+        return 0;
+    }
+
+    uint32_t shift = 16 - ADC_BITS_LUT[resolution];
+    size_t stride = buf.channels();
+    size_t n = buf.size() / stride;
+    const Sample *src = buf.data() + channel;
+    for (size_t i=0; i<n/2; i++, src += stride * 2) {
+        uint8_t lo = encode(adc_to_pcm(src[0], shift));
+        uint8_t hi = encode(adc_to_pcm(src[stride], shift));
+        dst[i] = lo | (hi << 4);
+    }
+    if (n & 1) {
+        // Pad the last byte.
+        dst[n / 2] = encode(adc_to_pcm(src[0], shift));
+    }
+    return (n + 1) / 2;
+}
+
+size_t IMAADPCM::decode(const uint8_t *src, SampleBuffer buf, uint32_t resolution) {
+    uint32_t shift = dac_shift(resolution);
+    Sample *dst = buf.data();
+    size_t n = buf.size();
+    for (size_t i=0; i<n/2; i++) {
+        dst[i * 2 + 0] = pcm_to_dac(decode(src[i] & 0x0F), shift);
+        dst[i * 2 + 1] = pcm_to_dac(decode(src[i] >> 4), shift);
+    }
+    if (n & 1) {
+        dst[n - 1] = pcm_to_dac(decode(src[n / 2] & 0x0F), shift);
+    }
+    return (n + 1) / 2;
+}
+
+size_t IMAADPCM::encode_block(const int16_t *src, size_t n, uint8_t *dst) {
+    if (n == 0) {
+        return 0;
+    }
+
+    // The first sample is stored in the header, uncompressed.
+    predictor = src[0];
+    dst[0] = (uint16_t) predictor;
+    dst[1] = (uint16_t) predictor >> 8;
+    dst[2] = index;
+    dst[3] = 0;
+
+    size_t size = AN_ADPCM_BLOCK_HEADER + encode(src + 1, n - 1, dst + AN_ADPCM_BLOCK_HEADER);
+    if ((n - 1) & 1) {
+        // Pad the last byte.
+        dst[size++] = encode(src[n - 1]);
+    }
+    return size;
+}
+
+size_t IMAADPCM::decode_block(const uint8_t *src, size_t size, int16_t *dst, size_t n) {
+    if (size < AN_ADPCM_BLOCK_HEADER || n == 0) {
+        return 0;
+    }
+    if (n > block_samples(size)) {
+        n = block_samples(size);
+    }
+
+    reset((int16_t) (src[0] | (src[1] << 8)), src[2]);
+    dst[0] = predictor;
+    src += AN_ADPCM_BLOCK_HEADER;
+    for (size_t i=1; i<n; i++) {
+        uint8_t code = src[(i - 1) >> 1];
+        dst[i] = decode((i & 1) ? (code & 0x0F) : (code >> 4));
+    }
+    return n;
+}
+
+size_t IMAADPCM::decode_block(const uint8_t *src, size_t size, SampleBuffer buf, uint32_t resolution) {
+    if (size < AN_ADPCM_BLOCK_HEADER || buf.size() == 0) {
+        return 0;
+    }
+
+    uint32_t shift = dac_shift(resolution);
+    size_t n = block_samples(size);
+    if (n > buf.size()) {
+        n = buf.size();
+    }
+
+    reset((int16_t) (src[0] | (src[1] << 8)), src[2]);
+    Sample *dst = buf.data();
+    dst[0] = pcm_to_dac(predictor, shift);
+    src += AN_ADPCM_BLOCK_HEADER;
+    for (size_t i=1; i<n; i++) {
+        uint8_t code = src[(i - 1) >> 1];
+        dst[i] = pcm_to_dac(decode((i & 1) ? (code & 0x0F) : (code >> 4)), shift);
+    }
+    return n;
+}
@@ -0,0 +1,72 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __ADPCM_H__
+#define __ADPCM_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+// WAV IMA ADPCM block header: predictor (2 bytes), step index, reserved.
+#define AN_ADPCM_BLOCK_HEADER   (4)
+#define AN_ADPCM_WAVE_FORMAT    (0x0011)
+
+// IMA ADPCM codec, 4 bits per sample. Codes are packed two per byte, low
+// nibble first, which is the nibble order used by WAV files. One instance
+// holds the state of a single channel.
+class IMAADPCM {
+    private:
+        int32_t predictor;
+        int32_t index;
+
+    public:
+        IMAADPCM(int16_t predictor=0, uint8_t index=0) {
+            reset(predictor, index);
+        }
+
+        void reset(int16_t predictor=0, uint8_t index=0) {
+            this->predictor = predictor;
+            this->index = (index > 88) ? 88 : index;
+        }
+
+        uint8_t encode(int16_t sample);
+        int16_t decode(uint8_t code);
+
+        // Encode/decode n samples (n/2 bytes). n must be even.
+        size_t encode(const int16_t *src, size_t n, uint8_t *dst);
+        size_t decode(const uint8_t *src, size_t n, int16_t *dst);
+
+        // Encode one channel of an ADC buffer sampled at the given resolution. With
+        // an odd number of frames, the last byte holds a single code in its low nibble.
+        size_t encode(SampleBuffer buf, uint8_t *dst, uint32_t resolution, size_t channel=0);
+        // Fill a DAC buffer, scaling to the resolution the DAC was started with.
+        // Returns the number of bytes used, including a last half-used byte.
+        size_t decode(const uint8_t *src, SampleBuffer buf, uint32_t resolution);
+
+        // WAV IMA ADPCM (mono) blocks, which start with a header that resets the state.
+        static size_t block_samples(size_t block_size) {
+            return (block_size - AN_ADPCM_BLOCK_HEADER) * 2 + 1;
+        }
+        size_t encode_block(const int16_t *src, size_t n, uint8_t *dst);
+        // Decodes up to n samples, block_samples(size) for the whole block.
+        size_t decode_block(const uint8_t *src, size_t size, int16_t *dst, size_t n);
+        size_t decode_block(const uint8_t *src, size_t size, SampleBuffer buf, uint32_t resolution);
+};
+
+#endif  // __ADPCM_H__
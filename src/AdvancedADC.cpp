@@ -20,10 +20,37 @@
 #include "Arduino.h"
 #include "HALConfig.h"
 #include "AdvancedADC.h"
+#include "DCBlock.h"
+#include "VrefCorrection.h"
 
 #define ADC_NP  ((ADCName) NC)
 #define ADC_PIN_ALT_MASK    (uint32_t) (ALT0 | ALT1 )
 
+struct adc_adaptive_t {
+    uint32_t latency;       // Target latency in us, 0 if adaptive mode is disabled.
+    size_t sizes[AN_MAX_BLOCK_SIZES];
+    size_t n_sizes;
+    size_t index;
+    uint32_t depth;         // Ready queue depth average (Q4).
+    uint32_t interval;      // Consumer read interval average in us.
+    uint32_t last_read;
+    uint32_t holdoff;
+};
+
+struct adc_gate_t {
+    uint32_t mode;          // AN_GATE_OFF if gating is disabled.
+    uint32_t on;            // Level that opens the gate.
+    uint32_t off;           // Level below which the gate closes.
+    size_t n_pre;           // Quiet buffers held before activity.
+    size_t n_post;          // Quiet buffers delivered after activity.
+    size_t remaining;
+    bool active;
+    bool skipped;           // Buffers were skipped since the last delivered one.
+    bool init;
+    int32_t baseline[AN_MAX_ADC_CHANNELS];
+    uint32_t n_skipped;
+};
+
 struct adc_descr_t {
     ADC_HandleTypeDef adc;
     DMA_HandleTypeDef dma;
@@ -32,10 +59,32 @@ struct adc_descr_t {
     uint32_t  tim_trig;
     DMABufferPool<Sample> *pool;
     DMABuffer<Sample> *dmabuf[2];
+    uint32_t sample_rate;
+    adc_adaptive_t adaptive;
+    bool low_latency;
+    uint32_t trigger;
+    volatile uint32_t events;
+    size_t history;     // History depth in buffers, 0 if history mode is disabled.
+    adc_gate_t gate;
+    Queue<DMABuffer<Sample>*> preroll;
+    uint32_t resolution;
+    bool dc_block;
+    DCBlock dc;
+    bool vref_correct;
+    VrefCorrection vref;
 };
 
 static uint32_t adc_pin_alt[3] = {0, ALT0, ALT1};
 
+static bool adc_pin_internal(PinName pin) {
+    return pin == ADC_TEMP || pin == ADC_VREF || pin == ADC_VBAT;
+}
+
+static const PinMap *adc_pin_map(PinName pin) {
+    // Internal channels have their own map, and are only connected to ADC3.
+    return adc_pin_internal(pin) ? PinMap_ADC_Internal : PinMap_ADC;
+}
+
 static adc_descr_t adc_descr_all[3] = {
     {{ADC1}, {DMA1_Stream1, {DMA_REQUEST_ADC1}}, DMA1_Stream1_IRQn, {TIM1}, ADC_EXTERNALTRIG_T1_TRGO,
         nullptr, {nullptr, nullptr}},
@@ -81,6 +130,10 @@ static void dac_descr_deinit(adc_descr_t *descr, bool dealloc_pool) {
         HAL_TIM_Base_Stop(&descr->tim);
         HAL_ADC_Stop_DMA(&descr->adc);
 
+        while (!descr->preroll.empty()) {
+            descr->preroll.pop()->release();
+        }
+
         for (size_t i=0; i<AN_ARRAY_SIZE(descr->dmabuf); i++) {
             if (descr->dmabuf[i]) {
                 descr->dmabuf[i]->release();
@@ -93,12 +146,121 @@ static void dac_descr_deinit(adc_descr_t *descr, bool dealloc_pool) {
                 delete descr->pool;
             }
             descr->pool = nullptr;
+            descr->adaptive = {};
+            descr->low_latency = false;
+            descr->trigger = AN_TRIGGER_TIMER;
+            descr->history = 0;
+            descr->gate = {};
+            descr->dc_block = false;
+            descr->vref_correct = false;
         }
     }
 }
 
+static int adc_descr_restart(adc_descr_t *descr, size_t n_samples) {
+    // Restart the DMA with a new buffer size. Samples converted while the DMA
+    // is stopped, and the partially filled DMA buffers, are dropped.
+    if (descr->trigger == AN_TRIGGER_TIMER) {
+        HAL_TIM_Base_Stop(&descr->tim);
+    }
+    HAL_ADC_Stop_DMA(&descr->adc);
+
+    for (size_t i=0; i<AN_ARRAY_SIZE(descr->dmabuf); i++) {
+        if (descr->dmabuf[i]) {
+            descr->dmabuf[i]->release();
+            descr->dmabuf[i] = nullptr;
+        }
+    }
+
+    descr->pool->samples(n_samples);
+    descr->dmabuf[0] = descr->pool->allocate();
+    descr->dmabuf[1] = descr->pool->allocate();
+    if (descr->dmabuf[0] == nullptr || descr->dmabuf[1] == nullptr) {
+        return 0;
+    }
+    // Buffers may have been written in place by the consumer (see the ISR).
+    descr->dmabuf[0]->invalidate();
+    descr->dmabuf[1]->invalidate();
+
+    // Flag the gap in the stream.
+    descr->dmabuf[0]->setflags(DMA_BUFFER_DISCONT);
+
+    if (HAL_ADC_Start_DMA(&descr->adc, (uint32_t *) descr->dmabuf[0]->data(), descr->dmabuf[0]->size()) != HAL_OK) {
+        return 0;
+    }
+    hal_dma_enable_dbm(&descr->dma, descr->dmabuf[0]->data(), descr->dmabuf[1]->data(), descr->low_latency);
+
+    // With AN_TRIGGER_DAC, the DAC's timer keeps running.
+    if (descr->trigger == AN_TRIGGER_TIMER && HAL_TIM_Base_Start(&descr->tim) != HAL_OK) {
+        return 0;
+    }
+    return 1;
+}
+
+static float adc_scan_time(adc_descr_t *descr, PinName *adc_pins, size_t n_ranks) {
+    // Time taken to convert the first n ranks of the scan sequence, in seconds.
+    float t = 0.0f;
+    for (size_t i=0; i<n_ranks; i++) {
+        t += hal_adc_get_conversion_time(&descr->adc, adc_pins[i]);
+    }
+    return t;
+}
+
+static uint32_t adc_block_us(adc_descr_t *descr, size_t index) {
+    return ((uint64_t) descr->adaptive.sizes[index] * 1000000) / descr->sample_rate;
+}
+
+static void adc_adaptive_update(adc_descr_t *descr) {
+    // Called by the consumer for every buffer read. The latency is estimated from
+    // the buffers waiting in the ready queue, and from the time it takes the
+    // consumer to come back for the next buffer. The block size is decreased if
+    // the latency exceeds the target, and increased (fewer interrupts) when the
+    // next block size is expected to stay well within the target.
+    adc_adaptive_t *a = &descr->adaptive;
+    uint32_t now = micros();
+    uint32_t block_us = adc_block_us(descr, a->index);
+
+    // Ready queue depth, not counting the buffer being read.
+    int32_t depth = (descr->pool->queued() - 1) << 4;
+    a->depth += (depth - (int32_t) a->depth) / 8;
+    if (a->last_read) {
+        int32_t interval = now - a->last_read;
+        a->interval += (interval - (int32_t) a->interval) / 8;
+    } else {
+        a->interval = block_us;
+    }
+    a->last_read = now;
+
+    if (a->holdoff) {
+        // Let the averages settle after a block size change.
+        a->holdoff--;
+        return;
+    }
+
+    size_t index = a->index;
+    uint32_t wait_us = (a->interval > block_us) ? a->interval : block_us;
+    uint64_t latency = (((uint64_t) a->depth * block_us) >> 4) + wait_us;
+    if (latency > a->latency) {
+        if (index > 0) {
+            index--;
+        }
+    } else if ((index + 1) < a->n_sizes && a->interval <= (block_us + block_us / 8)) {
+        uint64_t next = (((uint64_t) a->depth + 16) * adc_block_us(descr, index + 1)) >> 4;
+        if (next <= (a->latency * 3 / 4)) {
+            index++;
+        }
+    }
+
+    if (index != a->index && adc_descr_restart(descr, a->sizes[index])) {
+        a->index = index;
+        a->last_read = 0;
+        a->holdoff = 8;
+    }
+}
+
 bool AdvancedADC::available() {
-    if (descr != nullptr) {
+    // In history mode, buffers are only returned by snapshot().
+    if (descr != nullptr && descr->history == 0) {
         return descr->pool->readable();
     }
     return false;
@@ -106,15 +268,126 @@ bool AdvancedADC::available() {
 
 DMABuffer<Sample> &AdvancedADC::read() {
     static DMABuffer<Sample> NULLBUF;
-    if (descr != nullptr) {
+    if (descr != nullptr && descr->history == 0) {
         while (!available()) {
             __WFI();
         }
-        return *descr->pool->dequeue();
+        if (descr->adaptive.latency) {
+            adc_adaptive_update(descr);
+        }
+        DMABuffer<Sample> *buf = descr->pool->dequeue();
+        if (descr->vref_correct) {
+            descr->vref.compute(*buf);
+        }
+        if (descr->dc_block) {
+            // Remove the DC offset in place, while the samples are fetched
+            // into the cache for the consumer anyway.
+            descr->dc.compute(*buf);
+        }
+        return *buf;
     }
     return NULLBUF;
 }
 
+static bool adc_gate_pass(adc_descr_t *descr, DMABuffer<Sample> *buf) {
+    // Called from the ISR for every completed buffer in gated mode. Returns true
+    // if the buffer should be delivered, after the held pre-roll buffers.
+    adc_gate_t *g = &descr->gate;
+    size_t n_channels = buf->channels();
+    size_t n_frames = buf->size() / n_channels;
+    const Sample *data = buf->data();
+    buf->invalidate();
+
+    // The gate's metric is the largest of all channels.
+    uint32_t metric = 0;
+    for (size_t c=0; c<n_channels; c++) {
+        uint32_t m = 0;
+        if (g->mode == AN_GATE_THRESHOLD) {
+            for (size_t i=c; i<buf->size(); i+=n_channels) {
+                m = (data[i] > m) ? data[i] : m;
+            }
+        } else {
+            uint32_t sum = 0;
+            uint64_t sum2 = 0;
+            for (size_t i=c; i<buf->size(); i+=n_channels) {
+                sum += data[i];
+                sum2 += (uint32_t) data[i] * data[i];
+            }
+            int32_t mean = sum / n_frames;
+            if (g->mode == AN_GATE_ENERGY) {
+                // Variance, compared with the squared levels.
+                m = (sum2 / n_frames) - ((uint64_t) mean * mean);
+            } else {
+                if (!g->init) {
+                    g->baseline[c] = mean;
+                }
+                m = abs(mean - g->baseline[c]);
+                if (!g->active) {
+                    // The baseline follows slow drifts while quiet.
+                    g->baseline[c] += (mean - g->baseline[c]) / 8;
+                }
+            }
+        }
+        metric = (m > metric) ? m : metric;
+    }
+    g->init = true;
+
+    bool active = (metric >= g->on) || (g->active && metric >= g->off);
+    g->active = active;
+    if (active) {
+        g->remaining = g->n_post;
+    } else if (g->remaining) {
+        g->remaining--;
+        active = true;
+    }
+
+    if (active) {
+        // Deliver the pre-roll, oldest first. The first buffer delivered after
+        // skipped ones is flagged as discontinuous.
+        while (!descr->preroll.empty()) {
+            DMABuffer<Sample> *held = descr->preroll.pop();
+            if (g->skipped) {
+                held->setflags(DMA_BUFFER_DISCONT);
+                g->skipped = false;
+            }
+            descr->pool->enqueue(held);
+        }
+        if (g->skipped) {
+            buf->setflags(DMA_BUFFER_DISCONT);
+            g->skipped = false;
+        }
+    }
+    return active;
+}
+
+static DMABuffer<Sample> *adc_gate_hold(adc_descr_t *descr, DMABuffer<Sample> *buf) {
+    // Holds a quiet buffer as pre-roll, and returns the buffer to use for the
+    // next DMA transfer: a free one while the pre-roll fills up, then the oldest
+    // held buffer, whose samples are skipped.
+    adc_gate_t *g = &descr->gate;
+    if (g->n_pre) {
+        if (descr->preroll.size() < g->n_pre && descr->pool->writable()) {
+            descr->preroll.push(buf);
+            buf = descr->pool->allocate();
+            if (buf->channels() > 1) {
+                buf->setflags(DMA_BUFFER_INTRLVD);
+            }
+            return buf;
+        }
+        // The pre-roll is empty if it was just delivered and the pool has no
+        // free buffer, in which case the current buffer is reused.
+        if (!descr->preroll.empty()) {
+            DMABuffer<Sample> *oldest = descr->preroll.pop();
+            descr->preroll.push(buf);
+            buf = oldest;
+        }
+    }
+    buf->clrflags(DMA_BUFFER_DISCONT);
+    g->skipped = true;
+    g->n_skipped++;
+    return buf;
+}
+
 int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_samples, size_t n_buffers) {
     ADCName instance = ADC_NP;
 
@@ -134,7 +407,7 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
         PinName pin = (PinName) (adc_pins[0] | adc_pin_alt[i]); // First pin decides the ADC.
 
         // Check if pin is mapped.
-        if (pinmap_find_peripheral(pin, PinMap_ADC) == NC) {
+        if (pinmap_find_peripheral(pin, adc_pin_map(pin)) == NC) {
             break;
         }
 
@@ -142,7 +415,7 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
         for (size_t j=0; instance == ADC_NP && j<AN_ARRAY_SIZE(adc_descr_all); j++) {
             descr = &adc_descr_all[j];
             if (descr->pool == nullptr) {
-                ADCName tmp_instance = (ADCName) pinmap_peripheral(pin, PinMap_ADC);
+                ADCName tmp_instance = (ADCName) pinmap_peripheral(pin, adc_pin_map(pin));
                 if (descr->adc.Instance == ((ADC_TypeDef*) tmp_instance)) {
                     instance = tmp_instance;
                     adc_pins[0] = pin;
@@ -157,20 +430,24 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
         return 0;
     }
 
-    // Configure ADC pins.
-    pinmap_pinout(adc_pins[0], PinMap_ADC);
+    // Configure ADC pins. Internal channels have no pin to configure.
+    if (!adc_pin_internal(adc_pins[0])) {
+        pinmap_pinout(adc_pins[0], PinMap_ADC);
+    }
     uint8_t ch_init = 1;
     for (size_t i=1; i<n_channels; i++) {
         for (size_t j=0; j<AN_ARRAY_SIZE(adc_pin_alt); j++) {
             // Calculate alternate function pin.
             PinName pin = (PinName) (adc_pins[i] | adc_pin_alt[j]);
             // Check if pin is mapped.
-            if (pinmap_find_peripheral(pin, PinMap_ADC) == NC) {
+            if (pinmap_find_peripheral(pin, adc_pin_map(pin)) == NC) {
                 break;
             }
             // Check if pin is connected to the selected ADC.
-            if (instance == pinmap_peripheral(pin, PinMap_ADC)) {
-                pinmap_pinout(pin, PinMap_ADC);
+            if (instance == pinmap_peripheral(pin, adc_pin_map(pin))) {
+                if (!adc_pin_internal(pin)) {
+                    pinmap_pinout(pin, PinMap_ADC);
+                }
                 adc_pins[i] = pin;
                 ch_init++;
                 break;
@@ -184,12 +461,26 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
     }
 
     // Allocate DMA buffer pool.
-    descr->pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers);
+    descr->pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers, mem_region);
     if (descr->pool == nullptr) {
         return 0;
     }
+    if (!*descr->pool) {
+        // Not enough memory in the selected region.
+        delete descr->pool;
+        descr->pool = nullptr;
+        descr = nullptr;
+        return 0;
+    }
     descr->dmabuf[0] = descr->pool->allocate();
     descr->dmabuf[1] = descr->pool->allocate();
+    // Discard any lines cached from the memory's previous use.
+    descr->dmabuf[0]->invalidate();
+    descr->dmabuf[1]->invalidate();
+    descr->sample_rate = sample_rate;
+    descr->low_latency = low_latency;
+    descr->trigger = trig_source;
+    descr->resolution = resolution;
 
     // Init and config DMA.
     if (hal_dma_config(&descr->dma, descr->dma_irqn, DMA_PERIPH_TO_MEMORY) < 0) {
@@ -197,7 +488,17 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
     }
 
     // Init and config ADC.
-    if (hal_adc_config(&descr->adc, ADC_RES_LUT[resolution], descr->tim_trig, adc_pins, n_channels) < 0) {
+    // In DAC trigger mode, the ADC is armed and waits for the DAC's timer to start.
+    uint32_t tim_trig = (descr->trigger == AN_TRIGGER_DAC) ? ADC_EXTERNALTRIG_T4_TRGO : descr->tim_trig;
+    if (hal_adc_config(&descr->adc, ADC_RES_LUT[resolution], tim_trig, adc_pins, n_channels) < 0) {
+        return 0;
+    }
+
+    // The scan sequence must complete within a sample period, or triggers would
+    // be missed. Internal channels, with their long sampling time, limit the rate.
+    if (adc_scan_time(descr, adc_pins, n_channels) * sample_rate > 1.0f) {
+        dac_descr_deinit(descr, true);
+        descr = nullptr;
         return 0;
     }
 
@@ -207,18 +508,347 @@ int AdvancedADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_sampl
         return 0;
     }
 
-    // Re/enable DMA double buffer mode.
-    hal_dma_enable_dbm(&descr->dma, descr->dmabuf[0]->data(), descr->dmabuf[1]->data());
+    // Re/enable DMA double buffer mode. The half transfer interrupt is only
+    // enabled in low latency mode.
+    hal_dma_enable_dbm(&descr->dma, descr->dmabuf[0]->data(), descr->dmabuf[1]->data(), descr->low_latency);
 
     // Init, config and start the ADC timer.
-    hal_tim_config(&descr->tim, sample_rate);
-    if (HAL_TIM_Base_Start(&descr->tim) != HAL_OK) {
-        return 0;
+    if (descr->trigger == AN_TRIGGER_TIMER) {
+        hal_tim_config(&descr->tim, sample_rate);
+        if (HAL_TIM_Base_Start(&descr->tim) != HAL_OK) {
+            return 0;
+        }
     }
     
     return 1;
 }
 
+int AdvancedADC::memory(uint32_t region)
+{
+    // The region is used by the next call to begin().
+    if (AN_MEM_REGION(region) >= AN_MEM_REGIONS || (descr && descr->pool)) {
+        return 0;
+    }
+    mem_region = region;
+    return 1;
+}
+
+int AdvancedADC::resize(size_t n_buffers)
+{
+    // The two buffers owned by the DMA are part of the pool, and at least
+    // one more buffer is needed to deliver samples.
+    if (descr == nullptr || descr->pool == nullptr || n_buffers < 3) {
+        return 0;
+    }
+    return descr->pool->resize(n_buffers) == n_buffers;
+}
+
+int AdvancedADC::adaptive(uint32_t latency_us, size_t n_sizes, const size_t *sizes)
+{
+    // Block sizes must be in increasing order, and fit in the buffers allocated by begin().
+    // Not supported with AN_TRIGGER_DAC, since restarting the DMA while the DAC runs
+    // would lose the alignment of the ADC and DAC samples.
+    if (descr == nullptr || descr->pool == nullptr || n_sizes > AN_MAX_BLOCK_SIZES
+     || descr->trigger == AN_TRIGGER_DAC) {
+        return 0;
+    }
+
+    for (size_t i=0; i<n_sizes; i++) {
+        if (sizes[i] == 0 || sizes[i] > descr->pool->max_samples() || (i && sizes[i] <= sizes[i-1])) {
+            return 0;
+        }
+    }
+
+    adc_adaptive_t *a = &descr->adaptive;
+    *a = {};
+    if (latency_us == 0 || n_sizes == 0) {
+        // Disable adaptive mode, and switch back to the full buffer size.
+        if (descr->pool->samples() != descr->pool->max_samples()) {
+            return adc_descr_restart(descr, descr->pool->max_samples());
+        }
+        return 1;
+    }
+
+    for (size_t i=0; i<n_sizes; i++) {
+        a->sizes[i] = sizes[i];
+    }
+    a->n_sizes = n_sizes;
+
+    // Start with the largest block that fits in the target latency.
+    for (size_t i=1; i<n_sizes; i++) {
+        if (adc_block_us(descr, i) <= latency_us) {
+            a->index = i;
+        }
+    }
+    a->holdoff = 8;
+    if (!adc_descr_restart(descr, a->sizes[a->index])) {
+        return 0;
+    }
+    a->latency = latency_us;
+    return 1;
+}
+
+int AdvancedADC::lowlatency(bool enable)
+{
+    // Low latency mode is used by the next call to begin().
+    if (descr && descr->pool) {
+        return 0;
+    }
+    low_latency = enable;
+    return 1;
+}
+
+int AdvancedADC::trigger(uint32_t source)
+{
+    // The trigger source is used by the next call to begin(). With AN_TRIGGER_DAC,
+    // the sample rate is set by the DAC, and sampling starts with the DAC's output.
+    if ((descr && descr->pool) || source > AN_TRIGGER_DAC) {
+        return 0;
+    }
+    trig_source = source;
+    return 1;
+}
+
+size_t AdvancedADC::peek(Sample *dst, size_t n, bool wait)
+{
+    // Copy up to n of the most recent samples, rounded down to whole frames,
+    // from the buffer currently being filled by the DMA, and return the number
+    // of samples copied. If wait is true, wait for the next DMA event (half or
+    // full transfer in low latency mode) first.
+    if (descr == nullptr || descr->pool == nullptr || dst == nullptr) {
+        return 0;
+    }
+
+    if (wait) {
+        uint32_t events = descr->events;
+        while (events == descr->events) {
+            __WFI();
+        }
+    }
+
+    size_t ct, ndtr, fifo;
+    DMABuffer<Sample> *buf;
+    do {
+        // Make sure the buffer didn't switch while reading the transfer count.
+        // The FIFO level is read last: samples counted by NDTR and flushed to
+        // memory in between are then only under-reported.
+        ct = hal_dma_get_ct(&descr->dma);
+        buf = descr->dmabuf[ct];
+        ndtr = hal_dma_get_ndtr(&descr->dma);
+        fifo = hal_dma_get_fifo_level(&descr->dma);
+    } while (ct != hal_dma_get_ct(&descr->dma));
+
+    // Samples still in the DMA FIFO aren't in memory yet.
+    size_t n_channels = buf->channels();
+    size_t count = (buf->size() - ndtr);
+    size_t pending = (fifo + sizeof(Sample) - 1) / sizeof(Sample);
+    count = (count > pending) ? (count - pending) : 0;
+    count -= count % n_channels;
+    n = (n < count) ? (n - n % n_channels) : count;
+
+    // The buffer is only written by the DMA, so it's safe to invalidate all of it.
+    buf->invalidate();
+    memcpy(dst, buf->data() + (count - n), n * sizeof(Sample));
+    return n;
+}
+
+int AdvancedADC::history(size_t n_buffers)
+{
+    // Two buffers are owned by the DMA, and at least one free buffer is
+    // needed to keep sampling while a snapshot is held.
+    if (descr == nullptr || descr->pool == nullptr || descr->gate.mode || (n_buffers + 3) > descr->pool->count()) {
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (n_buffers == 0) {
+        // Return the history to the free queue.
+        descr->history = 0;
+        descr->pool->flush();
+    } else {
+        descr->history = n_buffers;
+    }
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+int AdvancedADC::gate(uint32_t mode, uint32_t level, uint32_t hysteresis, size_t n_pre, size_t n_post)
+{
+    // Two buffers are owned by the DMA, and at least one free buffer is needed
+    // to deliver buffers while the pre-roll is held.
+    if (descr == nullptr || descr->pool == nullptr || descr->history || mode > AN_GATE_BASELINE
+     || hysteresis > level || (n_pre + 3) > descr->pool->count()) {
+        return 0;
+    }
+
+    // Stop gating and return the held buffers to the free queue.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    descr->gate.mode = AN_GATE_OFF;
+    __set_PRIMASK(primask);
+    while (!descr->preroll.empty()) {
+        descr->preroll.pop()->release();
+    }
+
+    if (mode == AN_GATE_OFF) {
+        return 1;
+    }
+    if (n_pre && !descr->preroll.resize(n_pre)) {
+        return 0;
+    }
+
+    adc_gate_t *g = &descr->gate;
+    g->on = level;
+    g->off = level - hysteresis;
+    if (mode == AN_GATE_ENERGY) {
+        // The energy is compared as a variance.
+        g->on *= level;
+        g->off *= (level - hysteresis);
+    }
+    g->n_pre = n_pre;
+    g->n_post = n_post;
+    g->remaining = 0;
+    g->active = false;
+    g->skipped = false;
+    g->init = false;
+    g->mode = mode;
+    return 1;
+}
+
+int AdvancedADC::dcblock(uint32_t shift)
+{
+    // Removes the DC offset of every channel from the buffers returned by
+    // read(), which are re-centred on mid-scale. A shift of 0 disables it.
+    if (descr == nullptr || descr->pool == nullptr) {
+        return 0;
+    }
+    if (shift == 0) {
+        descr->dc_block = false;
+        return 1;
+    }
+    // Resolutions are 8 to 16 bits, in steps of 2.
+    uint32_t bits = 8 + 2 * descr->resolution;
+    if (!descr->dc.begin(shift, 1 << (bits - 1))) {
+        return 0;
+    }
+    descr->dc_block = true;
+    return 1;
+}
+
+int AdvancedADC::correction(bool enable)
+{
+    // Rescales the buffers returned by read() by the supply voltage measured
+    // with the VREFINT channel, which must be in the scan sequence.
+    if (descr == nullptr || descr->pool == nullptr) {
+        return 0;
+    }
+    if (!enable) {
+        descr->vref_correct = false;
+        return 1;
+    }
+    int vref_channel = -1, temp_channel = -1;
+    for (size_t i=0; i<n_channels; i++) {
+        if (adc_pins[i] == ADC_VREF) {
+            vref_channel = i;
+        } else if (adc_pins[i] == ADC_TEMP) {
+            temp_channel = i;
+        }
+    }
+    if (!descr->vref.begin(descr->resolution, vref_channel, temp_channel)) {
+        return 0;
+    }
+    descr->vref_correct = true;
+    return 1;
+}
+
+float AdvancedADC::vdda()
+{
+    // Returns the supply voltage measured in the last buffer read, in volts.
+    if (descr == nullptr || !descr->vref_correct) {
+        return 0.0f;
+    }
+    return descr->vref.vdda();
+}
+
+float AdvancedADC::temperature()
+{
+    // Returns the die temperature measured in the last buffer read, in degrees C.
+    if (descr == nullptr || !descr->vref_correct) {
+        return 0.0f;
+    }
+    return descr->vref.temperature();
+}
+
+uint32_t AdvancedADC::gated()
+{
+    // Returns the number of buffers skipped by the gate.
+    if (descr == nullptr || descr->pool == nullptr) {
+        return 0;
+    }
+    return descr->gate.n_skipped;
+}
+
+size_t AdvancedADC::snapshot(DMABuffer<Sample> **buffers, size_t n)
+{
+    // Freezes the history, and returns up to n of the most recent buffers, oldest
+    // first. The buffers are owned by the caller, and must be released. Sampling
+    // continues into the free buffers, and a new history is started.
+    if (descr == nullptr || descr->pool == nullptr || descr->history == 0 || buffers == nullptr) {
+        return 0;
+    }
+
+    size_t count = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    size_t queued = descr->pool->queued();
+    for (size_t i=0; i<queued; i++) {
+        DMABuffer<Sample> *buf = descr->pool->dequeue();
+        if ((queued - i) > n) {
+            // Older than the requested window.
+            descr->pool->release(buf);
+        } else {
+            buffers[count++] = buf;
+        }
+    }
+    __set_PRIMASK(primask);
+    return count;
+}
+
+float AdvancedADC::rate()
+{
+    // Returns the achieved sample rate.
+    if (descr == nullptr || descr->pool == nullptr) {
+        return 0.0f;
+    }
+    if (descr->trigger == AN_TRIGGER_DAC) {
+        // Timer of DAC channel 1.
+        TIM_HandleTypeDef tim = {TIM4};
+        return hal_tim_get_frequency(&tim);
+    }
+    return hal_tim_get_frequency(&descr->tim);
+}
+
+float AdvancedADC::skew()
+{
+    // Returns the delay between the samples of two successive pins in the scan
+    // sequence, in seconds. Internal channels take longer, see skew(channel).
+    if (descr == nullptr || descr->pool == nullptr) {
+        return 0.0f;
+    }
+    return hal_adc_get_conversion_time(&descr->adc, NC);
+}
+
+float AdvancedADC::skew(size_t channel)
+{
+    // Returns the delay between the samples of the first channel and of the
+    // given channel in the scan sequence, in seconds.
+    if (descr == nullptr || descr->pool == nullptr || channel >= n_channels) {
+        return 0.0f;
+    }
+    return adc_scan_time(descr, adc_pins, channel);
+}
+
 int AdvancedADC::stop()
 {
     dac_descr_deinit(descr, true);
@@ -231,23 +861,39 @@ AdvancedADC::~AdvancedADC()
 }
 
 extern "C" {
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *adc) {
+    // Only called in low latency mode, wakes up peek().
+    adc_descr_t *descr = adc_descr_get(adc->Instance);
+    descr->events++;
+}
+
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *adc) {
     adc_descr_t *descr = adc_descr_get(adc->Instance);
+    descr->events++;
     // NOTE: CT bit is inverted, to get the DMA buffer that's Not currently in use.
     size_t ct = ! hal_dma_get_ct(&descr->dma);
 
     // Timestamp the buffer. TODO: Should move to timer IRQ.
     descr->dmabuf[ct]->timestamp(HAL_GetTick());
 
-    if (descr->pool->writable()) {
+    bool recycle = descr->history && descr->pool->queued() >= descr->history;
+    if (descr->gate.mode && !adc_gate_pass(descr, descr->dmabuf[ct])) {
+        // Quiet buffer, held as pre-roll or skipped.
+        descr->dmabuf[ct] = adc_gate_hold(descr, descr->dmabuf[ct]);
+    } else if (recycle || descr->pool->writable()) {
         // Make sure any cached data is discarded.
         descr->dmabuf[ct]->invalidate();
 
         // Move current DMA buffer to ready queue.
         descr->pool->enqueue(descr->dmabuf[ct]);
 
-        // Allocate a new free buffer.
-        descr->dmabuf[ct] = descr->pool->allocate();
+        // Allocate a new free buffer. In history mode, the oldest buffer
+        // is reused once the history is full.
+        if (recycle) {
+            descr->dmabuf[ct] = descr->pool->recycle();
+        } else {
+            descr->dmabuf[ct] = descr->pool->allocate();
+        }
 
         // Currently, all multi-channel buffers are interleaved.
         if (descr->dmabuf[ct]->channels() > 1) {
@@ -257,6 +903,10 @@ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *adc) {
         descr->dmabuf[ct]->setflags(DMA_BUFFER_DISCONT);
     }
 
+    // Discard any lines written by the CPU while the buffer was in use (e.g. by
+    // in-place processing), so they can't be evicted over the DMA's samples.
+    descr->dmabuf[ct]->invalidate();
+
     // Update the next DMA target pointer.
     // NOTE: If the pool was empty, the same buffer is reused.
     hal_dma_update_memory(&descr->dma, descr->dmabuf[ct]->data());
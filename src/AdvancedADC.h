@@ -30,19 +30,31 @@ class AdvancedADC {
     private:
         size_t n_channels;
         adc_descr_t *descr;
+        uint32_t mem_region;
+        bool low_latency;
+        uint32_t trig_source;
         PinName adc_pins[AN_MAX_ADC_CHANNELS];
+        static PinName pin_name(pin_size_t pin) {
+            // Internal channels aren't Arduino pins.
+            switch (pin) {
+                case AN_ADC_TEMP:    return ADC_TEMP;
+                case AN_ADC_VREFINT: return ADC_VREF;
+                case AN_ADC_VBAT:    return ADC_VBAT;
+            }
+            return analogPinToPinName(pin);
+        }
 
     public:
         template <typename ... T>
-        AdvancedADC(pin_size_t p0, T ... args): n_channels(0), descr(nullptr) {
+        AdvancedADC(pin_size_t p0, T ... args): n_channels(0), descr(nullptr), mem_region(AN_MEM_HEAP), low_latency(false), trig_source(AN_TRIGGER_TIMER) {
             static_assert(sizeof ...(args) < AN_MAX_ADC_CHANNELS,
                     "A maximum of 5 channels can be sampled successively.");
 
             for (auto p : {p0, args...}) {
-                adc_pins[n_channels++] = analogPinToPinName(p);
+                adc_pins[n_channels++] = pin_name(p);
             }
         }
-        AdvancedADC(): n_channels(0), descr(nullptr) {}
+        AdvancedADC(): n_channels(0), descr(nullptr), mem_region(AN_MEM_HEAP), low_latency(false), trig_source(AN_TRIGGER_TIMER) {}
         ~AdvancedADC();
         bool available();
         SampleBuffer read();
@@ -50,12 +62,29 @@ class AdvancedADC {
         int begin(uint32_t resolution, uint32_t sample_rate, size_t n_samples, size_t n_buffers, size_t n_pins, pin_size_t *pins) {
             if (n_pins > AN_MAX_ADC_CHANNELS) n_pins = AN_MAX_ADC_CHANNELS;
             for (size_t i = 0; i < n_pins; ++i) {
-                adc_pins[i] = analogPinToPinName(pins[i]);
+                adc_pins[i] = pin_name(pins[i]);
             }
             n_channels = n_pins;
             return begin(resolution, sample_rate, n_samples, n_buffers);
         }
         int stop();
+        float rate();
+        float skew();
+        float skew(size_t channel);
+        int memory(uint32_t region);
+        int resize(size_t n_buffers);
+        int adaptive(uint32_t latency_us, size_t n_sizes, const size_t *sizes);
+        int lowlatency(bool enable);
+        int trigger(uint32_t source);
+        size_t peek(Sample *dst, size_t n, bool wait=false);
+        int history(size_t n_buffers);
+        size_t snapshot(DMABuffer<Sample> **buffers, size_t n);
+        int gate(uint32_t mode, uint32_t level=0, uint32_t hysteresis=0, size_t n_pre=0, size_t n_post=0);
+        uint32_t gated();
+        int dcblock(uint32_t shift);
+        int correction(bool enable);
+        float vdda();
+        float temperature();
 };
 
 #endif /* ARDUINO_ADVANCED_ADC_H_ */
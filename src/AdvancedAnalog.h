@@ -32,11 +32,30 @@ enum {
     AN_RESOLUTION_16 = 4U,
 };
 
+enum {
+    AN_TRIGGER_TIMER = 0U,  // The ADC's own timer (default).
+    AN_TRIGGER_DAC   = 1U,  // The timer of DAC channel 1, to sample in lockstep with the DAC.
+};
+
+enum {
+    AN_GATE_OFF       = 0U, // Every buffer is delivered (default).
+    AN_GATE_THRESHOLD = 1U, // A sample is above the level.
+    AN_GATE_ENERGY    = 2U, // The RMS around the buffer's mean is above the level.
+    AN_GATE_BASELINE  = 3U, // The buffer's mean moved from the baseline by more than the level.
+};
+
 typedef uint16_t                Sample;     // Sample type used for ADC/DAC.
 typedef DMABuffer<Sample>       &SampleBuffer;
 
+// Internal channels, which can be passed to AdvancedADC in place of pins. These
+// are only connected to ADC3, so every other channel must be on ADC3 as well.
+#define AN_ADC_TEMP             ((pin_size_t) 0xF0) // Temperature sensor.
+#define AN_ADC_VREFINT          ((pin_size_t) 0xF1) // Internal voltage reference.
+#define AN_ADC_VBAT             ((pin_size_t) 0xF2) // VBAT, divided by 4.
+
 #define AN_MAX_ADC_CHANNELS     (5)
 #define AN_MAX_DAC_CHANNELS     (1)
+#define AN_MAX_BLOCK_SIZES      (4)
 #define AN_ARRAY_SIZE(a)        (sizeof(a) / sizeof(a[0]))
 
 #endif  // __ADVANCED_ANALOG_H__
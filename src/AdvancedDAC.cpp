@@ -167,11 +167,18 @@ int AdvancedDAC::begin(uint32_t resolution, uint32_t frequency, size_t n_samples
     }
 
     // Allocate DMA buffer pool.
-    descr->pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers);
+    descr->pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers, mem_region);
     if (descr->pool == nullptr) {
         descr = nullptr;
         return 0;
     }
+    if (!*descr->pool) {
+        // Not enough memory in the selected region.
+        delete descr->pool;
+        descr->pool = nullptr;
+        descr = nullptr;
+        return 0;
+    }
     descr->resolution = DAC_RES_LUT[resolution];
 
     // Init and config DMA.
@@ -210,6 +217,34 @@ int AdvancedDAC::frequency(uint32_t const frequency)
     }
 }
 
+float AdvancedDAC::rate()
+{
+    // Returns the achieved sample rate.
+    if (descr == nullptr) {
+        return 0.0f;
+    }
+    return hal_tim_get_frequency(&descr->tim);
+}
+
+uint32_t AdvancedDAC::channel()
+{
+    // Returns the DAC channel of the pin, 1 (A12) or 2 (A13), 0 if there's no pin.
+    if (n_channels == 0) {
+        return 0;
+    }
+    return STM_PIN_CHANNEL(pinmap_function(dac_pins[0], PinMap_DAC));
+}
+
+int AdvancedDAC::memory(uint32_t region)
+{
+    // The region is used by the next call to begin().
+    if (AN_MEM_REGION(region) >= AN_MEM_REGIONS || descr != nullptr) {
+        return 0;
+    }
+    mem_region = region;
+    return 1;
+}
+
 AdvancedDAC::~AdvancedDAC()
 {
     dac_descr_deinit(descr, true);
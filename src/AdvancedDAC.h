@@ -30,11 +30,12 @@ class AdvancedDAC {
     private:
         size_t n_channels;
         dac_descr_t *descr;
+        uint32_t mem_region;
         PinName dac_pins[AN_MAX_DAC_CHANNELS];
 
     public:
         template <typename ... T>
-        AdvancedDAC(pin_size_t p0, T ... args): n_channels(0), descr(nullptr) {
+        AdvancedDAC(pin_size_t p0, T ... args): n_channels(0), descr(nullptr), mem_region(AN_MEM_HEAP) {
             static_assert(sizeof ...(args) < AN_MAX_DAC_CHANNELS,
                     "A maximum of 1 channel is currently supported.");
 
@@ -47,9 +48,12 @@ class AdvancedDAC {
         bool available();
         SampleBuffer dequeue();
         void write(SampleBuffer dmabuf);
-        int begin(uint32_t resolution, uint32_t frequency, size_t n_samples=0, size_t n_buffers=0);
+        int begin(uint32_t resolution, uint32_t frequency, size_t n_samples, size_t n_buffers);
         int stop();
         int frequency(uint32_t const frequency);
+        float rate();
+        int memory(uint32_t region);
+        uint32_t channel();
 };
 
 #endif /* ARDUINO_ADVANCED_DAC_H_ */
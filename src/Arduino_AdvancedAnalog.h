@@ -26,5 +26,22 @@
 
 #include "AdvancedADC.h"
 #include "AdvancedDAC.h"
+#include "FrameWriter.h"
+#include "RiceCodec.h"
+#include "ADPCM.h"
+#include "SampleRecorder.h"
+#include "SampleReplay.h"
+#include "SyntheticADC.h"
+#include "SampleStream.h"
+#include "Pipeline.h"
+#include "CoreLink.h"
+#include "Goertzel.h"
+#include "FrequencyMeter.h"
+#include "DelayEstimator.h"
+#include "DDS.h"
+#include "ResponseAnalyzer.h"
+#include "LockIn.h"
+#include "DCBlock.h"
+#include "VrefCorrection.h"
 
 #endif /* ADVANCEDANALOGREDUX_ARDUINO_ADVANCEDANALOG_H */
@@ -0,0 +1,304 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "CoreLink.h"
+#if !defined(ARDUINO_ARCH_MBED)
+#include <thread>
+#endif
+
+#if defined(CORE_CM7) || defined(CORE_CM4)
+#define LINK_HSEM_RX    (owner ? (AN_LINK_HSEM_ID + 1) : AN_LINK_HSEM_ID)
+#define LINK_HSEM_TX    (owner ? AN_LINK_HSEM_ID : (AN_LINK_HSEM_ID + 1))
+#if defined(CORE_CM7)
+#define LINK_HSEM_IRQN  HSEM1_IRQn
+#else
+#define LINK_HSEM_IRQN  HSEM2_IRQn
+#endif
+
+static void link_hsem_init(uint32_t id) {
+    // The HSEM interrupt is left disabled in the NVIC: with SEVONPEND a pending
+    // interrupt still wakes up WFE, so no handler is needed, and handlers used
+    // by other libraries (e.g. RPC) are not affected.
+    __HAL_RCC_HSEM_CLK_ENABLE();
+    HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(id));
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+}
+
+static void link_hsem_deinit(uint32_t id) {
+    HAL_HSEM_DeactivateNotification(__HAL_HSEM_SEMID_TO_MASK(id));
+}
+
+static bool link_hsem_poll(uint32_t id) {
+    uint32_t mask = __HAL_HSEM_SEMID_TO_MASK(id);
+    if (__HAL_HSEM_GET_FLAG(mask)) {
+        __HAL_HSEM_CLEAR_FLAG(mask);
+        NVIC_ClearPendingIRQ(LINK_HSEM_IRQN);
+        return true;
+    }
+    return false;
+}
+#endif
+
+static inline void link_clean(volatile void *ptr, size_t size) {
+    // Write back cached shared memory, so the other core can see it.
+    #if __DCACHE_PRESENT
+    SCB_CleanDCache_by_Addr((uint32_t *) ptr, size);
+    #endif
+}
+
+static inline void link_invalidate(volatile void *ptr, size_t size) {
+    // Discard cached shared memory, to see the other core's writes.
+    #if __DCACHE_PRESENT
+    SCB_InvalidateDCache_by_Addr((uint32_t *) ptr, size);
+    #endif
+}
+
+link_block_t *CoreLink::entries(size_t queue) {
+    return ((link_block_t *) (shm + 1)) + queue * (n_slots + 1);
+}
+
+bool CoreLink::push(size_t queue, const link_block_t *block) {
+    // Single producer side of the queue, only writes head.
+    link_queue_t *q = &shm->queues[queue];
+    link_invalidate(&q->tail, sizeof(q->tail));
+    uint32_t head = q->head;
+    uint32_t next = (head + 1) % (n_slots + 1);
+    if (next == q->tail) {
+        return false;
+    }
+    link_block_t *entry = &entries(queue)[head];
+    *entry = *block;
+    link_clean(entry, sizeof(link_block_t));
+    __DMB();
+    q->head = next;
+    link_clean(&q->head, sizeof(q->head));
+    __DSB();
+    notify();
+    return true;
+}
+
+bool CoreLink::pop(size_t queue, link_block_t *block) {
+    // Single consumer side of the queue, only writes tail.
+    link_queue_t *q = &shm->queues[queue];
+    link_invalidate(&q->head, sizeof(q->head));
+    uint32_t tail = q->tail;
+    if (tail == q->head) {
+        return false;
+    }
+    __DMB();
+    link_block_t *entry = &entries(queue)[tail];
+    link_invalidate(entry, sizeof(link_block_t));
+    *block = *entry;
+    __DMB();
+    q->tail = (tail + 1) % (n_slots + 1);
+    link_clean(&q->tail, sizeof(q->tail));
+    return true;
+}
+
+void CoreLink::notify() {
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+    // Taking and releasing the semaphore raises an interrupt on the other core.
+    if (HAL_HSEM_FastTake(LINK_HSEM_TX) == HAL_OK) {
+        HAL_HSEM_Release(LINK_HSEM_TX, 0);
+    }
+    #endif
+}
+
+void CoreLink::wait() {
+    // Sleep until the other core sends a notification.
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+    if (!link_hsem_poll(LINK_HSEM_RX)) {
+        __WFE();
+    }
+    #elif defined(ARDUINO_ARCH_MBED)
+    __WFI();
+    #else
+    std::this_thread::yield();
+    #endif
+}
+
+int CoreLink::begin(size_t n_slots) {
+    // Owner side: formats the shared memory.
+    if (shm == nullptr || n_slots == 0 || ((uintptr_t) shm % 32) || size(n_slots) > shm_size) {
+        return 0;
+    }
+
+    handles.reset(new DMABuffer<Sample>*[n_slots]);
+    if (!handles) {
+        return 0;
+    }
+    for (size_t i=0; i<n_slots; i++) {
+        handles[i] = nullptr;
+    }
+
+    owner = true;
+    this->n_slots = n_slots;
+    shm->magic = 0;
+    shm->version = AN_LINK_VERSION;
+    shm->n_slots = n_slots;
+    for (size_t i=0; i<AN_ARRAY_SIZE(shm->queues); i++) {
+        shm->queues[i].head = 0;
+        shm->queues[i].tail = 0;
+    }
+    link_clean(shm, sizeof(link_shm_t));
+    __DMB();
+    // The magic is written last, the remote side waits for it.
+    shm->magic = AN_LINK_MAGIC;
+    link_clean(shm, sizeof(link_shm_t));
+
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+    link_hsem_init(LINK_HSEM_RX);
+    #endif
+    return 1;
+}
+
+int CoreLink::attach(uint32_t timeout_ms) {
+    // Remote side: waits for the owner to format the shared memory.
+    if (shm == nullptr || ((uintptr_t) shm % 32)) {
+        return 0;
+    }
+
+    uint32_t start = millis();
+    do {
+        link_invalidate(shm, sizeof(link_shm_t));
+        if (shm->magic == AN_LINK_MAGIC) {
+            break;
+        }
+        delay(1);
+    } while ((millis() - start) < timeout_ms);
+
+    if (shm->magic != AN_LINK_MAGIC || shm->version != AN_LINK_VERSION || size(shm->n_slots) > shm_size) {
+        return 0;
+    }
+
+    views.reset(new DMABuffer<Sample>[shm->n_slots]);
+    if (!views) {
+        return 0;
+    }
+    owner = false;
+    n_slots = shm->n_slots;
+
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+    link_hsem_init(LINK_HSEM_RX);
+    #endif
+    return 1;
+}
+
+bool CoreLink::send(DMABuffer<Sample> &buf) {
+    // Owner: hands a buffer to the remote side. Remote: returns a buffer received.
+    link_block_t block;
+    if (n_slots == 0 || !buf) {
+        return false;
+    }
+
+    if (owner) {
+        for (block.handle=0; block.handle<n_slots; block.handle++) {
+            if (handles[block.handle] == nullptr) {
+                break;
+            }
+        }
+        if (block.handle == n_slots) {
+            return false;
+        }
+        // Write back any samples modified by this core.
+        buf.flush();
+    } else {
+        block.handle = &buf - views.get();
+        if (block.handle >= n_slots) {
+            return false;
+        }
+    }
+
+    block.data = (uintptr_t) buf.data();
+    block.size = buf.size();
+    block.channels = buf.channels();
+    block.timestamp = buf.timestamp();
+    block.flags = (buf.getflags(DMA_BUFFER_DISCONT) ? DMA_BUFFER_DISCONT : 0) |
+                  (buf.getflags(DMA_BUFFER_INTRLVD) ? DMA_BUFFER_INTRLVD : 0);
+
+    if (!push(owner ? 0 : 1, &block)) {
+        return false;
+    }
+    if (owner) {
+        handles[block.handle] = &buf;
+    }
+    return true;
+}
+
+bool CoreLink::available() {
+    if (n_slots == 0) {
+        return false;
+    }
+    link_queue_t *q = &shm->queues[owner ? 1 : 0];
+    link_invalidate(&q->head, sizeof(q->head));
+    return q->head != q->tail;
+}
+
+DMABuffer<Sample> &CoreLink::receive() {
+    // Owner: returns a buffer processed by the remote side, which must be released
+    // (or written to a DAC). Remote: returns a buffer to process, which must be sent
+    // back with send(). Waits for a buffer.
+    static DMABuffer<Sample> NULLBUF;
+    link_block_t block;
+    if (n_slots == 0) {
+        return NULLBUF;
+    }
+
+    while (!pop(owner ? 1 : 0, &block)) {
+        wait();
+    }
+
+    if (block.handle >= n_slots) {
+        return NULLBUF;
+    }
+
+    if (owner) {
+        DMABuffer<Sample> *buf = handles[block.handle];
+        handles[block.handle] = nullptr;
+        // Discard cached samples, the remote side may have modified them.
+        buf->invalidate();
+        return *buf;
+    }
+
+    // The remote side's views are not cacheable (the M4 has no data cache), and
+    // have no pool: they're only returned to the owner with send().
+    size_t n_channels = block.channels ? block.channels : 1;
+    DMABuffer<Sample> *view = &views[block.handle];
+    *view = DMABuffer<Sample>(nullptr, block.size / n_channels, n_channels, (Sample *) block.data, false);
+    view->timestamp(block.timestamp);
+    view->setflags(block.flags);
+    return *view;
+}
+
+int CoreLink::stop() {
+    #if defined(CORE_CM7) || defined(CORE_CM4)
+    if (n_slots) {
+        link_hsem_deinit(LINK_HSEM_RX);
+    }
+    #endif
+    if (owner && shm) {
+        // Buffers still held by the remote side are not released, since the
+        // remote side may still be using them.
+        shm->magic = 0;
+        link_clean(shm, sizeof(link_shm_t));
+    }
+    n_slots = 0;
+    return 1;
+}
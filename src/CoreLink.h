@@ -0,0 +1,93 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __CORE_LINK_H__
+#define __CORE_LINK_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+#define AN_LINK_MAGIC       (0x4B4E4C41U)   // "ALNK"
+#define AN_LINK_VERSION     (1)
+#ifndef AN_LINK_HSEM_ID
+#define AN_LINK_HSEM_ID     (28)            // Uses AN_LINK_HSEM_ID and AN_LINK_HSEM_ID + 1.
+#endif
+
+// One buffer descriptor, in its own cache line.
+struct alignas(32) link_block_t {
+    uintptr_t data;
+    uint32_t handle;
+    uint32_t size;
+    uint32_t channels;
+    uint32_t timestamp;
+    uint32_t flags;
+};
+
+// Ring indices, in separate cache lines since each is written by one core.
+struct link_queue_t {
+    alignas(32) volatile uint32_t head;
+    alignas(32) volatile uint32_t tail;
+};
+
+struct alignas(32) link_shm_t {
+    volatile uint32_t magic;
+    uint32_t version;
+    uint32_t n_slots;
+    link_queue_t queues[2];     // 0: owner to remote, 1: remote to owner.
+    // Followed by 2 * (n_slots + 1) link_block_t entries.
+};
+
+// Passes sample buffers between the M7 and M4 cores (or two threads on the host)
+// through a shared memory block at an address both sides agree on. The owner
+// side (the core that runs the ADC/DAC DMA) sends buffers with send(), the remote
+// side receives them with receive(), processes them in place, and sends them back.
+// Only descriptors are exchanged, so the buffer pool must be allocated from memory
+// both cores can access (e.g. adc.memory(AN_MEM_USER) with a region in SRAM4).
+// Each side wakes the other one up with a hardware semaphore (HSEM) notification.
+class CoreLink {
+    private:
+        link_shm_t *shm;
+        size_t shm_size;
+        uint32_t n_slots;
+        bool owner;
+        std::unique_ptr<DMABuffer<Sample>*[]> handles;  // Owner: buffers sent.
+        std::unique_ptr<DMABuffer<Sample>[]> views;     // Remote: buffers received.
+
+        link_block_t *entries(size_t queue);
+        bool push(size_t queue, const link_block_t *block);
+        bool pop(size_t queue, link_block_t *block);
+        void notify();
+        void wait();
+
+    public:
+        CoreLink(void *mem, size_t size): shm((link_shm_t *) mem), shm_size(size), n_slots(0), owner(false) {
+        }
+        static size_t size(size_t n_slots) {
+            // Shared memory size needed for n_slots buffers in flight.
+            return sizeof(link_shm_t) + 2 * (n_slots + 1) * sizeof(link_block_t);
+        }
+        int begin(size_t n_slots);
+        int attach(uint32_t timeout_ms=1000);
+        bool send(DMABuffer<Sample> &buf);
+        bool available();
+        DMABuffer<Sample> &receive();
+        int stop();
+};
+
+#endif  // __CORE_LINK_H__
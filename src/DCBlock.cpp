@@ -0,0 +1,67 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "DCBlock.h"
+
+int DCBlock::begin(uint32_t shift, uint32_t center) {
+    // Also restarts the offset tracking from the next buffer.
+    if (shift == 0 || shift > AN_DC_BLOCK_MAX_SHIFT || center == 0 || center > 32768) {
+        return 0;
+    }
+    this->shift = shift;
+    this->center = center;
+    // Samples are clamped to twice the center, e.g. 0 to 65535 for 32768.
+    max = (center * 2) - 1;
+    n_channels = 0;
+    return 1;
+}
+
+void DCBlock::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    if (n_channels == 0 || n_channels > AN_MAX_ADC_CHANNELS) {
+        return;
+    }
+
+    Sample *data = buf.data();
+    if (n_channels != this->n_channels) {
+        // Start from the first samples, to skip the initial settling.
+        for (size_t c=0; c<n_channels; c++) {
+            state[c] = (int32_t) data[c] << AN_DC_BLOCK_FRAC_BITS;
+        }
+        this->n_channels = n_channels;
+    }
+
+    for (size_t i=0; i<buf.size(); i+=n_channels) {
+        for (size_t c=0; c<n_channels; c++) {
+            int32_t x = data[i + c];
+            state[c] += ((x << AN_DC_BLOCK_FRAC_BITS) - state[c]) >> shift;
+            int32_t y = x - ((state[c] + (1 << (AN_DC_BLOCK_FRAC_BITS - 1))) >> AN_DC_BLOCK_FRAC_BITS) + center;
+            data[i + c] = (y < 0) ? 0 : (y > max) ? max : y;
+        }
+    }
+}
+
+float DCBlock::offset(size_t channel) {
+    // Returns the tracked offset of a channel, in ADC counts.
+    if (channel >= n_channels) {
+        return 0.0f;
+    }
+    return (float) state[channel] / (1 << AN_DC_BLOCK_FRAC_BITS);
+}
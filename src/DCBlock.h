@@ -0,0 +1,57 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __DC_BLOCK_H__
+#define __DC_BLOCK_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "Pipeline.h"
+
+#define AN_DC_BLOCK_FRAC_BITS   (12)
+#define AN_DC_BLOCK_MAX_SHIFT   (AN_DC_BLOCK_FRAC_BITS)
+
+// One-pole DC-blocking high-pass filter, in place over interleaved buffers. The
+// offset of each channel is tracked with a one-pole low-pass filter,
+// m += (x - m) >> shift, kept in fixed point with AN_DC_BLOCK_FRAC_BITS
+// fractional bits so there's no dead band, and subtracted from every sample,
+// which is re-centred on the given center (e.g. mid-scale). The -3 dB cutoff
+// is about fs / (2 * pi * 2^shift).
+class DCBlock : public PipelineStage {
+    private:
+        uint32_t shift;
+        int32_t center;
+        int32_t max;
+        size_t n_channels;
+        int32_t state[AN_MAX_ADC_CHANNELS];
+
+    public:
+        DCBlock(uint32_t shift=8, uint32_t center=32768): shift(8), center(32768), max(65535), n_channels(0) {
+            begin(shift, center);
+        }
+        int begin(uint32_t shift, uint32_t center=32768);
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        float offset(size_t channel);
+};
+
+#endif  // __DC_BLOCK_H__
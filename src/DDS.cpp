@@ -0,0 +1,84 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "DDS.h"
+
+// Sine table in Q15, with one extra entry for the interpolation.
+static int16_t dds_lut[(1 << AN_DDS_LUT_BITS) + 1];
+static bool dds_lut_init = false;
+
+int DDS::begin(float sample_rate, float frequency) {
+    if (sample_rate <= 0.0f) {
+        return 0;
+    }
+
+    if (!dds_lut_init) {
+        for (size_t i=0; i<AN_ARRAY_SIZE(dds_lut); i++) {
+            dds_lut[i] = lroundf(sinf(2.0f * (float) PI * i / (1 << AN_DDS_LUT_BITS)) * 32767);
+        }
+        dds_lut_init = true;
+    }
+    this->sample_rate = sample_rate;
+    acc = 0;
+    return this->frequency(frequency);
+}
+
+int DDS::frequency(float frequency) {
+    // Sets the frequency, keeping the phase continuous.
+    if (sample_rate == 0.0f || frequency < 0.0f || frequency >= (sample_rate / 2)) {
+        return 0;
+    }
+    inc = (uint32_t) ((double) frequency / sample_rate * 4294967296.0 + 0.5);
+    return 1;
+}
+
+float DDS::frequency() {
+    // Returns the exact frequency, after rounding of the step.
+    return (double) inc * sample_rate / 4294967296.0;
+}
+
+int32_t DDS::sine(uint32_t phase) {
+    // Returns sin(2 * pi * phase / 2^32) in Q15.
+    uint32_t index = phase >> (32 - AN_DDS_LUT_BITS);
+    int32_t frac = (phase >> (16 - AN_DDS_LUT_BITS)) & 0xFFFF;
+    int32_t y0 = dds_lut[index];
+    int32_t y1 = dds_lut[index + 1];
+    return y0 + (((y1 - y0) * frac) >> 16);
+}
+
+void DDS::generate(Sample *dst, size_t n, uint32_t amplitude, uint32_t offset, size_t stride) {
+    // Writes n samples of offset + amplitude * sin(phase), amplitude and offset
+    // in DAC codes.
+    for (size_t i=0; i<n; i++, dst+=stride) {
+        int32_t y = (int32_t) offset + ((next() * (int32_t) amplitude) >> 15);
+        *dst = (y < 0) ? 0 : y;
+    }
+}
+
+void DDS::generate(SampleBuffer buf, uint32_t amplitude, uint32_t offset) {
+    // Fills all the channels of a buffer with the same signal.
+    size_t n_channels = buf.channels() ? buf.channels() : 1;
+    size_t n_frames = buf.size() / n_channels;
+    uint32_t start = acc;
+    for (size_t c=0; c<n_channels; c++) {
+        acc = start;
+        generate(buf.data() + c, n_frames, amplitude, offset, n_channels);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __DDS_H__
+#define __DDS_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+#define AN_DDS_LUT_BITS         (10)
+
+// Direct digital synthesizer: a 32-bit phase accumulator and a sine table with
+// linear interpolation. The phase of any sample is known from the phase at the
+// start of a buffer and the step, so the same DDS that drives a DAC can give
+// the reference of an ADC buffer sampled at the same time.
+class DDS {
+    private:
+        float sample_rate;
+        uint32_t acc;
+        uint32_t inc;
+
+    public:
+        DDS(): sample_rate(0), acc(0), inc(0) {
+        }
+        int begin(float sample_rate, float frequency=0.0f);
+        int frequency(float frequency);
+        float frequency();
+        float rate() {
+            return sample_rate;
+        }
+        uint32_t phase() {
+            return acc;
+        }
+        void phase(uint32_t phase) {
+            acc = phase;
+        }
+        uint32_t step() {
+            return inc;
+        }
+        void step(uint32_t step) {
+            inc = step;
+        }
+        int32_t next() {
+            int32_t y = sine(acc);
+            acc += inc;
+            return y;
+        }
+        void generate(Sample *dst, size_t n, uint32_t amplitude, uint32_t offset, size_t stride=1);
+        void generate(SampleBuffer buf, uint32_t amplitude, uint32_t offset);
+        static int32_t sine(uint32_t phase);
+        static int32_t cosine(uint32_t phase) {
+            return sine(phase + 0x40000000U);
+        }
+};
+
+#endif  // __DDS_H__
@@ -22,6 +22,7 @@
 
 #include "Arduino.h"
 #include "Queue.h"
+#include "DMAMemory.h"
 
 #ifndef __SCB_DCACHE_LINE_SIZE
 #define __SCB_DCACHE_LINE_SIZE  32
@@ -63,6 +64,7 @@ template <class, size_t> class DMABufferPool;
 
 template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABuffer {
     typedef DMABufferPool<T, A> Pool;
+    friend Pool;
 
     private:
         Pool *pool;
@@ -71,10 +73,11 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABuffer {
         T *ptr;
         uint32_t ts;
         uint32_t flags;
+        bool cacheable;
 
     public:
-        DMABuffer(Pool *pool=nullptr, size_t samples=0, size_t channels=0, T *mem=nullptr):
-            pool(pool), n_samples(samples), n_channels(channels), ptr(mem), ts(0), flags(0) {
+        DMABuffer(Pool *pool=nullptr, size_t samples=0, size_t channels=0, T *mem=nullptr, bool cacheable=true):
+            pool(pool), n_samples(samples), n_channels(channels), ptr(mem), ts(0), flags(0), cacheable(cacheable) {
         }
 
         T *data() {
@@ -91,7 +94,7 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABuffer {
 
         void flush() {
             #if __DCACHE_PRESENT
-            if (ptr) {
+            if (ptr && cacheable) {
                 SCB_CleanDCache_by_Addr(data(), bytes());
             }
             #endif
@@ -99,7 +102,7 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABuffer {
 
         void invalidate() {
             #if __DCACHE_PRESENT
-            if (ptr) {
+            if (ptr && cacheable) {
                 SCB_InvalidateDCache_by_Addr(data(), bytes());
             }
             #endif
@@ -117,6 +120,12 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABuffer {
             return n_channels;
         }
 
+        size_t max_samples() {
+            // Largest number of samples per channel of the buffers from this
+            // buffer's pool, which can change size (see DMABufferPool::samples()).
+            return pool ? pool->max_samples() : n_samples;
+        }
+
         void release() {
             if (pool && ptr) {
                 pool->release(this);
@@ -156,47 +165,185 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABufferPool {
     private:
         Queue<DMABuffer<T>*> wr_queue;
         Queue<DMABuffer<T>*> rd_queue;
-        std::unique_ptr<uint8_t, decltype(&AlignedAlloc<A>::free)> pool;
+        Queue<DMABuffer<T>*> spare;
+        std::unique_ptr<uint8_t, decltype(&DMAMemory::free<A>)> pool;
+        size_t n_samples;
+        size_t n_channels;
+        size_t n_buffers;
+        size_t n_pooled;
+        size_t n_active;
+        size_t bufsize;
+        uint32_t region;
+
+        bool owned(DMABuffer<T> *buf) {
+            // Returns true if the buffer's memory is part of the initial pool.
+            uint8_t *ptr = (uint8_t *) buf->data();
+            return (ptr >= pool.get()) && (ptr < (pool.get() + n_pooled * bufsize));
+        }
+
+        void retire(DMABuffer<T> *buf) {
+            // Buffers added by resize() own their memory.
+            if (!owned(buf)) {
+                DMAMemory::free<A>(buf->data());
+            }
+            delete buf;
+        }
 
     public:
-        DMABufferPool(size_t n_samples, size_t n_channels, size_t n_buffers):
-            wr_queue(n_buffers), rd_queue(n_buffers), pool(nullptr, AlignedAlloc<A>::free) {
+        DMABufferPool(size_t n_samples, size_t n_channels, size_t n_buffers, uint32_t region=AN_MEM_HEAP):
+            wr_queue(n_buffers), rd_queue(n_buffers), spare(n_buffers), pool(nullptr, DMAMemory::free<A>),
+            n_samples(n_samples), n_channels(n_channels), n_buffers(0), n_pooled(0), n_active(n_samples), bufsize(0), region(region) {
             // Round up to next multiple of alignment.
-            size_t bufsize = AlignedAlloc<A>::round(n_samples * n_channels * sizeof(T));
-            if (bufsize && rd_queue && wr_queue) {
-                // Allocate an aligned memory pool for DMA buffers.
-                pool.reset((uint8_t *) AlignedAlloc<A>::malloc(n_buffers * bufsize));
+            bufsize = AlignedAlloc<A>::round(n_samples * n_channels * sizeof(T));
+            if (bufsize && rd_queue && wr_queue && spare) {
+                // Allocate an aligned, DMA reachable memory pool for DMA buffers.
+                pool.reset((uint8_t *) DMAMemory::malloc<A>(n_buffers * bufsize, region));
                 if (!pool) {
                     // Failed to allocate memory pool.
                     return;
                 }
+                n_pooled = n_buffers;
                 // Allocate the DMA buffers, initialize them using aligned
                 // pointers from the pool, and add them to the ready queue.
                 for (size_t i=0; i<n_buffers; i++) {
                     DMABuffer<T> *buf =  new DMABuffer<T>(
-                        this, n_samples, n_channels, (T *) &pool.get()[i * bufsize]
+                        this, n_samples, n_channels, (T *) &pool.get()[i * bufsize], DMAMemory::cacheable(region)
                     );
                     if (buf == nullptr) {
                         break;
                     }
                     wr_queue.push(buf);
+                    this->n_buffers++;
                 }
             }
         }
 
         ~DMABufferPool() {
-            size_t count = 0;
-            DMABuffer<T> *buf = nullptr;
-
             while (readable()) {
-                delete dequeue();
-                count ++;
+                retire(dequeue());
             }
 
             while (writable()) {
-                delete allocate();
-                count ++;
+                retire(allocate());
+            }
+
+            while (!spare.empty()) {
+                delete spare.pop();
+            }
+        }
+
+        size_t count() {
+            // Total number of buffers, including the ones in use.
+            return n_buffers;
+        }
+
+        size_t resize(size_t n) {
+            // Grow or shrink the pool while it's in use: new buffers are added to the
+            // free queue, and retired buffers are taken from the free queue only, so
+            // buffers owned by the DMA or the consumer are never touched. Returns the
+            // new number of buffers, which may be larger than requested if not enough
+            // buffers were free.
+            if (!pool || n == 0) {
+                return n_buffers;
+            }
+
+            if (n > n_buffers) {
+                // Make room in the queues first.
+                if (!wr_queue.resize(n) || !rd_queue.resize(n)) {
+                    return n_buffers;
+                }
+                while (n_buffers < n) {
+                    // Reuse buffers from the initial pool, then allocate new ones.
+                    DMABuffer<T> *buf = spare.pop();
+                    if (buf == nullptr) {
+                        T *mem = (T *) DMAMemory::malloc<A>(bufsize, region);
+                        if (mem == nullptr) {
+                            break;
+                        }
+                        buf = new DMABuffer<T>(this, n_samples, n_channels, mem, DMAMemory::cacheable(region));
+                        if (buf == nullptr) {
+                            DMAMemory::free<A>(mem);
+                            break;
+                        }
+                    }
+                    release(buf);
+                    n_buffers++;
+                }
+            } else if (n < n_buffers) {
+                std::unique_ptr<DMABuffer<T>*[]> retired(new DMABuffer<T>*[n_buffers - n]);
+                size_t n_retired = 0;
+                if (!retired) {
+                    return n_buffers;
+                }
+
+                // Take the free buffers with interrupts disabled, since the free
+                // queue's consumer is the DMA ISR. Buffers allocated by resize() are
+                // retired first, buffers from the initial pool are kept as spares.
+                #if defined(ARDUINO_ARCH_MBED)
+                uint32_t primask = __get_PRIMASK();
+                __disable_irq();
+                #endif
+                size_t n_free = wr_queue.size();
+                for (size_t i=0; i<n_free; i++) {
+                    DMABuffer<T> *buf = wr_queue.pop();
+                    if ((n_buffers - n_retired) > n && !owned(buf)) {
+                        retired[n_retired++] = buf;
+                    } else {
+                        wr_queue.push(buf);
+                    }
+                }
+                for (size_t i=0; i<n_free && (n_buffers - n_retired) > n; i++) {
+                    DMABuffer<T> *buf = wr_queue.pop();
+                    if (buf == nullptr) {
+                        break;
+                    }
+                    retired[n_retired++] = buf;
+                }
+                #if defined(ARDUINO_ARCH_MBED)
+                __set_PRIMASK(primask);
+                #endif
+
+                // Free the memory outside of the critical section.
+                for (size_t i=0; i<n_retired; i++) {
+                    if (owned(retired[i])) {
+                        retired[i]->clrflags();
+                        spare.push(retired[i]);
+                    } else {
+                        retire(retired[i]);
+                    }
+                }
+                n_buffers -= n_retired;
+            }
+            return n_buffers;
+        }
+
+        size_t samples() {
+            // Number of samples per channel in newly allocated buffers.
+            return n_active;
+        }
+
+        bool samples(size_t n) {
+            // Change the number of samples per channel of the buffers, up to the
+            // size the pool was created with. Buffers already in use keep their
+            // size, and the new size applies to buffers allocated from now on.
+            if (n == 0 || n > n_samples) {
+                return false;
             }
+            n_active = n;
+            return true;
+        }
+
+        size_t max_samples() {
+            return n_samples;
+        }
+
+        size_t queued() {
+            // Number of buffers in the ready queue.
+            return rd_queue.size();
+        }
+
+        operator bool() const {
+            return (pool.get() != nullptr);
         }
 
         bool writable() {
@@ -215,7 +362,11 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABufferPool {
 
         DMABuffer<T> *allocate() {
             // Get a DMA buffer from the free queue.
-            return wr_queue.pop();
+            DMABuffer<T> *buf = wr_queue.pop();
+            if (buf != nullptr) {
+                buf->n_samples = n_active;
+            }
+            return buf;
         }
 
         void release(DMABuffer<T> *buf) {
@@ -233,5 +384,15 @@ template <class T, size_t A=__SCB_DCACHE_LINE_SIZE> class DMABufferPool {
             // Return a DMA buffer from the ready queue.
             return rd_queue.pop();
         }
+
+        DMABuffer<T> *recycle() {
+            // Take the oldest buffer from the ready queue for reuse as a free buffer.
+            DMABuffer<T> *buf = rd_queue.pop();
+            if (buf != nullptr) {
+                buf->clrflags();
+                buf->n_samples = n_active;
+            }
+            return buf;
+        }
 };
 #endif //__DMA_BUFFER_H__
@@ -0,0 +1,166 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "DMAMemory.h"
+#include "AdvancedAnalog.h"
+
+struct mem_block_t {
+    uintptr_t addr;
+    size_t size;
+};
+
+struct mem_region_t {
+    uintptr_t base;
+    size_t size;
+    bool nocache;
+    size_t n_blocks;
+    mem_block_t blocks[AN_MEM_MAX_BLOCKS];  // Sorted by address.
+};
+
+struct mem_range_t {
+    uintptr_t base;
+    size_t size;
+};
+
+static mem_region_t mem_regions[AN_MEM_REGIONS] = {
+    {0x00000000, 0x00000, false, 0, {}},    // Heap
+    {0x24000000, 0x80000, false, 0, {}},    // AXI SRAM
+    {0x30000000, 0x20000, false, 0, {}},    // SRAM1
+    {0x30020000, 0x20000, false, 0, {}},    // SRAM2
+    {0x30040000, 0x08000, false, 0, {}},    // SRAM3
+    {0x00000000, 0x00000, false, 0, {}},    // User
+};
+
+// Memories that can't be accessed by the DMA1/DMA2 controllers.
+static const mem_range_t mem_dma_unreachable[] = {
+    {0x00000000, 0x10000},          // ITCM
+    {0x20000000, 0x20000},          // DTCM
+};
+
+static bool mem_overlaps(uintptr_t a, size_t a_size, uintptr_t b, size_t b_size) {
+    return (a < (b + b_size)) && (b < (a + a_size));
+}
+
+bool DMAMemory::reachable(const void *ptr, size_t size) {
+    for (size_t i=0; i<AN_ARRAY_SIZE(mem_dma_unreachable); i++) {
+        if (mem_overlaps((uintptr_t) ptr, size, mem_dma_unreachable[i].base, mem_dma_unreachable[i].size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DMAMemory::axi_sram(const void *ptr, size_t size) {
+    mem_region_t *r = &mem_regions[AN_MEM_AXI_SRAM];
+    return ((uintptr_t) ptr >= r->base) && (((uintptr_t) ptr + size) <= (r->base + r->size));
+}
+
+static int mem_region_nocache(uint32_t region) {
+    mem_region_t *r = &mem_regions[region];
+    if (r->nocache) {
+        return 1;
+    }
+
+    // The MPU region size must be a power of two, and the base aligned to it.
+    if (r->size < 32 || (r->size & (r->size - 1)) || (r->base & (r->size - 1))) {
+        return 0;
+    }
+
+    #if __MPU_PRESENT
+    // Write back and discard any cached lines, before the memory becomes non-cacheable.
+    #if __DCACHE_PRESENT
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *) r->base, r->size);
+    #endif
+
+    MPU_Region_InitTypeDef mpu = {0};
+    mpu.Enable              = MPU_REGION_ENABLE;
+    // Use the highest region numbers, which take priority over the system regions.
+    mpu.Number              = MPU_REGION_NUMBER15 - (region - AN_MEM_SRAM1);
+    mpu.BaseAddress         = r->base;
+    mpu.Size                = __builtin_ctz(r->size) - 1;
+    mpu.SubRegionDisable    = 0x00;
+    mpu.TypeExtField        = MPU_TEX_LEVEL1;
+    mpu.AccessPermission    = MPU_REGION_FULL_ACCESS;
+    mpu.DisableExec         = MPU_INSTRUCTION_ACCESS_DISABLE;
+    mpu.IsShareable         = MPU_ACCESS_SHAREABLE;
+    mpu.IsCacheable         = MPU_ACCESS_NOT_CACHEABLE;
+    mpu.IsBufferable        = MPU_ACCESS_NOT_BUFFERABLE;
+
+    HAL_MPU_Disable();
+    HAL_MPU_ConfigRegion(&mpu);
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+    #endif
+
+    r->nocache = true;
+    return 1;
+}
+
+int DMAMemory::region(uint32_t region, uintptr_t base, size_t size) {
+    if (region < AN_MEM_SRAM1 || region >= AN_MEM_REGIONS || mem_regions[region].n_blocks
+            || mem_regions[region].nocache || !reachable((void *) base, size)) {
+        return 0;
+    }
+    mem_regions[region].base = base;
+    mem_regions[region].size = size;
+    return 1;
+}
+
+void *DMAMemory::region_malloc(size_t size, uint32_t region, size_t align) {
+    bool nocache = (region & AN_MEM_NOCACHE);
+    region = AN_MEM_REGION(region);
+    if (region < AN_MEM_SRAM1 || region >= AN_MEM_REGIONS || size == 0) {
+        return nullptr;
+    }
+
+    // First fit: try the gap before each block, and then the end of the region.
+    mem_region_t *r = &mem_regions[region];
+    if (r->n_blocks == AN_MEM_MAX_BLOCKS || (nocache && !mem_region_nocache(region))) {
+        return nullptr;
+    }
+
+    uintptr_t start = r->base;
+    for (size_t i=0; i<=r->n_blocks; i++) {
+        uintptr_t addr = (start + (align - 1)) & ~((uintptr_t) align - 1);
+        uintptr_t end = (i < r->n_blocks) ? r->blocks[i].addr : (r->base + r->size);
+        if (addr + size <= end) {
+            memmove(&r->blocks[i + 1], &r->blocks[i], (r->n_blocks - i) * sizeof(mem_block_t));
+            r->blocks[i] = {addr, size};
+            r->n_blocks++;
+            return (void *) addr;
+        }
+        if (i < r->n_blocks) {
+            start = r->blocks[i].addr + r->blocks[i].size;
+        }
+    }
+    return nullptr;
+}
+
+bool DMAMemory::region_free(void *ptr) {
+    for (size_t j=AN_MEM_SRAM1; j<AN_MEM_REGIONS; j++) {
+        mem_region_t *r = &mem_regions[j];
+        for (size_t i=0; i<r->n_blocks; i++) {
+            if (r->blocks[i].addr == (uintptr_t) ptr) {
+                r->n_blocks--;
+                memmove(&r->blocks[i], &r->blocks[i + 1], (r->n_blocks - i) * sizeof(mem_block_t));
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,93 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __DMA_MEMORY_H__
+#define __DMA_MEMORY_H__
+
+#include "Arduino.h"
+
+// Memory regions DMA buffer pools can be allocated from. The heap regions use
+// malloc, the others are managed by a small allocator over a fixed address range.
+// NOTE: The D2 SRAMs are not used by the M7 core, but the M4 core firmware or
+// some peripherals (e.g. Ethernet descriptors in SRAM3) may use them, in which
+// case use DMAMemory::region() to restrict the range that can be used.
+//
+// Static regions can be OR'ed with AN_MEM_NOCACHE, to configure them as normal
+// non-cacheable memory with the MPU. Buffers allocated from a non-cacheable
+// region skip the cache maintenance (invalidate/flush), whose cost grows with
+// the buffer size, at the cost of slower CPU access to the samples.
+enum {
+    AN_MEM_HEAP     = 0U,   // Heap, anywhere the DMA can reach.
+    AN_MEM_AXI_SRAM = 1U,   // Heap, only if it's in AXI SRAM (D1 domain).
+    AN_MEM_SRAM1    = 2U,   // D2 domain SRAM1.
+    AN_MEM_SRAM2    = 3U,   // D2 domain SRAM2.
+    AN_MEM_SRAM3    = 4U,   // D2 domain SRAM3.
+    AN_MEM_USER     = 5U,   // Explicit address range set with DMAMemory::region().
+    AN_MEM_REGIONS,
+    AN_MEM_NOCACHE  = 0x100U, // Flag: make the region non-cacheable with the MPU.
+};
+
+#define AN_MEM_REGION(r)    ((r) & 0xFFU)
+
+#define AN_MEM_MAX_BLOCKS   (8)
+
+template <size_t A> class AlignedAlloc;
+
+class DMAMemory {
+    private:
+        static void *region_malloc(size_t size, uint32_t region, size_t align);
+        static bool region_free(void *ptr);
+
+    public:
+        // Sets the address range of a static region (SRAMx or user). Fails if the
+        // region has allocations, or the range isn't reachable by DMA1/DMA2.
+        static int region(uint32_t region, uintptr_t base, size_t size);
+
+        // Returns true if the range can be accessed by DMA1/DMA2, which can't
+        // reach the tightly coupled memories (ITCM/DTCM).
+        static bool reachable(const void *ptr, size_t size);
+
+        // Returns true if memory allocated from region needs cache maintenance.
+        static bool cacheable(uint32_t region) {
+            return !(region & AN_MEM_NOCACHE);
+        }
+
+        template <size_t A> static void *malloc(size_t size, uint32_t region) {
+            if (region == AN_MEM_HEAP || region == AN_MEM_AXI_SRAM) {
+                // NOTE: The heap can't be made non-cacheable.
+                void *ptr = AlignedAlloc<A>::malloc(size);
+                if (ptr && (!reachable(ptr, size) || (region == AN_MEM_AXI_SRAM && !axi_sram(ptr, size)))) {
+                    AlignedAlloc<A>::free(ptr);
+                    ptr = nullptr;
+                }
+                return ptr;
+            }
+            return region_malloc(size, region, A);
+        }
+
+        template <size_t A> static void free(void *ptr) {
+            if (ptr != nullptr && !region_free(ptr)) {
+                AlignedAlloc<A>::free(ptr);
+            }
+        }
+
+        static bool axi_sram(const void *ptr, size_t size);
+};
+
+#endif  // __DMA_MEMORY_H__
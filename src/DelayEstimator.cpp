@@ -0,0 +1,237 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "DelayEstimator.h"
+
+int DelayEstimator::begin(float sample_rate, float skew, size_t n_fft, size_t max_lag) {
+    // The transform size must be a power of 2, and half of it is zero padding.
+    if (sample_rate <= 0.0f || skew < 0.0f || n_fft < 4 || n_fft > AN_MAX_XCORR_SIZE || (n_fft & (n_fft - 1))) {
+        return 0;
+    }
+
+    if (max_lag == 0 || max_lag >= n_fft / 2) {
+        max_lag = n_fft / 2 - 1;
+    }
+
+    if (n_fft != this->n_fft) {
+        twiddles.reset(new float[n_fft]);
+        if (!twiddles) {
+            return 0;
+        }
+        for (size_t i=0; i<n_fft/2; i++) {
+            // e^(-j * 2 * pi * i / n_fft)
+            twiddles[2 * i + 0] = cosf(2.0f * (float) PI * i / n_fft);
+            twiddles[2 * i + 1] = -sinf(2.0f * (float) PI * i / n_fft);
+        }
+        spectra.reset();
+    }
+    this->sample_rate = sample_rate;
+    for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+        skews[c] = c * skew;
+    }
+    this->n_fft = n_fft;
+    this->max_lag = max_lag;
+    n_channels = 0;
+    n_blocks = 0;
+    memset(delays, 0, sizeof(delays));
+    memset(peaks, 0, sizeof(peaks));
+    return 1;
+}
+
+void DelayEstimator::fft(float *x) {
+    // In-place radix-2 complex FFT of n_fft interleaved re/im values.
+    for (size_t i=1, j=0; i<n_fft; i++) {
+        size_t bit = n_fft >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float re = x[2 * i], im = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = re;
+            x[2 * j + 1] = im;
+        }
+    }
+
+    for (size_t len=2; len<=n_fft; len<<=1) {
+        size_t stride = n_fft / len;
+        for (size_t i=0; i<n_fft; i+=len) {
+            for (size_t k=0; k<len/2; k++) {
+                float wr = twiddles[2 * k * stride], wi = twiddles[2 * k * stride + 1];
+                float *u = &x[2 * (i + k)];
+                float *v = &x[2 * (i + k + len / 2)];
+                float vr = v[0] * wr - v[1] * wi;
+                float vi = v[0] * wi + v[1] * wr;
+                v[0] = u[0] - vr;
+                v[1] = u[1] - vi;
+                u[0] += vr;
+                u[1] += vi;
+            }
+        }
+    }
+}
+
+void DelayEstimator::correlate(size_t a, size_t b) {
+    float *xa = &spectra[2 * n_fft * a];
+    float *xb = &spectra[2 * n_fft * b];
+    float *p = &spectra[2 * n_fft * n_channels];
+    float *r = &spectra[2 * n_fft * (n_channels + 1)];
+
+    // Whitened cross-spectrum Xb * conj(Xa) / |Xb * conj(Xa)|, and its conjugate,
+    // so the forward transform computes the inverse one. The DC bin is dropped.
+    p[0] = p[1] = r[0] = r[1] = 0.0f;
+    for (size_t k=1; k<n_fft; k++) {
+        float re = xb[2 * k] * xa[2 * k] + xb[2 * k + 1] * xa[2 * k + 1];
+        float im = xb[2 * k + 1] * xa[2 * k] - xb[2 * k] * xa[2 * k + 1];
+        float mag = sqrtf(re * re + im * im);
+        if (mag > 1e-12f) {
+            re /= mag;
+            im /= mag;
+        } else {
+            re = im = 0.0f;
+        }
+        p[2 * k] = r[2 * k] = re;
+        p[2 * k + 1] = im;
+        r[2 * k + 1] = -im;
+    }
+    fft(r);
+
+    // Find the peak within +/- max_lag, lags wrap around at n_fft.
+    int32_t best = 0;
+    float best_val = r[0];
+    for (int32_t lag=-(int32_t) max_lag; lag<=(int32_t) max_lag; lag++) {
+        float val = r[2 * ((lag + n_fft) % n_fft)];
+        if (val > best_val) {
+            best_val = val;
+            best = lag;
+        }
+    }
+
+    // Parabolic interpolation around the peak gives a first estimate, biased
+    // towards the nearest lag. It's refined with Newton's method on the
+    // continuous correlation r(t) = sum(Re(P[k] * e^(j * w[k] * t))), over the
+    // positive frequencies since the inputs are real.
+    float prev = r[2 * ((best - 1 + n_fft) % n_fft)];
+    float next = r[2 * ((best + 1 + n_fft) % n_fft)];
+    float denom = prev - 2.0f * best_val + next;
+    float lag = best + ((denom < 0.0f) ? 0.5f * (prev - next) / denom : 0.0f);
+    float w1 = 2.0f * (float) PI / n_fft;
+    for (size_t i=0; i<3; i++) {
+        float c1 = cosf(w1 * lag), s1 = sinf(w1 * lag);
+        float cr = c1, ci = s1;
+        float d1 = 0.0f, d2 = 0.0f;
+        for (size_t k=1; k<n_fft/2; k++) {
+            float w = w1 * k;
+            float re = p[2 * k] * cr - p[2 * k + 1] * ci;
+            float im = p[2 * k] * ci + p[2 * k + 1] * cr;
+            d1 -= w * im;
+            d2 -= w * w * re;
+            float tmp = cr * c1 - ci * s1;
+            ci = cr * s1 + ci * c1;
+            cr = tmp;
+        }
+        if (d2 >= 0.0f) {
+            break;
+        }
+        float step = d1 / d2;
+        if (step > 0.5f || step < -0.5f) {
+            break;
+        }
+        lag -= step;
+    }
+
+    // Channel b is sampled skews[b] - skews[a] after channel a.
+    delays[a][b] = lag / sample_rate + (skews[b] - skews[a]);
+    peaks[a][b] = best_val / n_fft;
+}
+
+int DelayEstimator::begin(AdvancedADC &adc, size_t n_fft, size_t max_lag) {
+    // Internal channels take longer to convert, so the skew of each channel is
+    // taken from the ADC, rather than a multiple of the skew between ranks.
+    if (!begin(adc.rate(), adc.skew(), n_fft, max_lag)) {
+        return 0;
+    }
+    for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+        skews[c] = adc.skew(c);
+    }
+    return 1;
+}
+
+void DelayEstimator::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    size_t n_frames = buf.size() / (n_channels ? n_channels : 1);
+    if (n_fft == 0 || n_channels < 2 || n_channels > AN_MAX_ADC_CHANNELS || n_frames == 0) {
+        return;
+    }
+
+    if (n_channels != this->n_channels || !spectra) {
+        // One spectrum per channel, the cross-spectrum and the correlation.
+        spectra.reset(new float[2 * n_fft * (n_channels + 2)]);
+        if (!spectra) {
+            return;
+        }
+        this->n_channels = n_channels;
+    }
+
+    // Use up to n_fft / 2 frames, zero padded, so the correlation doesn't wrap.
+    size_t n = (n_frames < n_fft / 2) ? n_frames : n_fft / 2;
+    const Sample *data = buf.data();
+    for (size_t c=0; c<n_channels; c++) {
+        float *x = &spectra[2 * n_fft * c];
+        uint32_t sum = 0;
+        for (size_t i=0; i<n; i++) {
+            sum += data[i * n_channels + c];
+        }
+        float mean = (float) sum / n;
+        for (size_t i=0; i<n; i++) {
+            x[2 * i] = data[i * n_channels + c] - mean;
+            x[2 * i + 1] = 0.0f;
+        }
+        memset(&x[2 * n], 0, (n_fft - n) * 2 * sizeof(float));
+        fft(x);
+    }
+
+    for (size_t a=0; a<n_channels; a++) {
+        for (size_t b=a+1; b<n_channels; b++) {
+            correlate(a, b);
+        }
+    }
+    n_blocks++;
+}
+
+float DelayEstimator::delay(size_t a, size_t b) {
+    // Returns the delay of channel b relative to channel a in seconds,
+    // positive if the signal reaches channel b after channel a.
+    if (a >= n_channels || b >= n_channels || a == b) {
+        return 0.0f;
+    }
+    return (a < b) ? delays[a][b] : -delays[b][a];
+}
+
+float DelayEstimator::peak(size_t a, size_t b) {
+    // Returns the height of the correlation peak, from 0 to 1, which can be
+    // used to reject estimates from blocks with no common signal.
+    if (a >= n_channels || b >= n_channels || a == b) {
+        return 0.0f;
+    }
+    return (a < b) ? peaks[a][b] : peaks[b][a];
+}
@@ -0,0 +1,71 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __DELAY_ESTIMATOR_H__
+#define __DELAY_ESTIMATOR_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "AdvancedADC.h"
+#include "Pipeline.h"
+
+#define AN_MAX_XCORR_SIZE       (2048)
+
+// Estimates the time delay between each pair of channels with a generalized
+// cross-correlation with phase transform (GCC-PHAT), e.g. for acoustic
+// localization. Each block is transformed once per channel, then the whitened
+// cross-spectrum of every pair is transformed back, and the correlation peak
+// is refined to a fraction of a sample. Channels of a scan sequence are
+// not sampled at the same time, so the skew between the ranks (see
+// AdvancedADC::skew()) is added back to the delays. As a pipeline stage,
+// buffers are passed on unchanged.
+class DelayEstimator : public PipelineStage {
+    private:
+        float sample_rate;
+        float skews[AN_MAX_ADC_CHANNELS];   // Sample time of each channel after the first.
+        size_t n_fft;
+        size_t max_lag;
+        size_t n_channels;
+        uint32_t n_blocks;
+        std::unique_ptr<float[]> twiddles;
+        std::unique_ptr<float[]> spectra;   // One spectrum per channel, then two scratch.
+        float delays[AN_MAX_ADC_CHANNELS][AN_MAX_ADC_CHANNELS];
+        float peaks[AN_MAX_ADC_CHANNELS][AN_MAX_ADC_CHANNELS];
+
+        void fft(float *x);
+        void correlate(size_t a, size_t b);
+
+    public:
+        DelayEstimator(): sample_rate(0), skews(), n_fft(0), max_lag(0), n_channels(0), n_blocks(0) {
+        }
+        int begin(float sample_rate, float skew, size_t n_fft, size_t max_lag=0);
+        int begin(AdvancedADC &adc, size_t n_fft, size_t max_lag=0);
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        float delay(size_t a, size_t b);
+        float peak(size_t a, size_t b);
+        uint32_t blocks() {
+            return n_blocks;
+        }
+};
+
+#endif  // __DELAY_ESTIMATOR_H__
@@ -0,0 +1,181 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "FrameWriter.h"
+#include "RiceCodec.h"
+
+static uint32_t crc32_lut[256];
+
+static void crc32_init() {
+    for (uint32_t i=0; i<256; i++) {
+        uint32_t c = i;
+        for (size_t j=0; j<8; j++) {
+            c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+        }
+        crc32_lut[i] = c;
+    }
+}
+
+uint32_t an_crc32(uint32_t crc, const uint8_t *data, size_t size) {
+    // The last LUT entry is never zero once initialized.
+    if (crc32_lut[255] == 0) {
+        crc32_init();
+    }
+    crc = ~crc;
+    for (size_t i=0; i<size; i++) {
+        crc = crc32_lut[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+FrameWriter::FrameWriter(Print &out, size_t batch_size, uint32_t encoding):
+    out(out), batch_size(batch_size), encoding(encoding), length(0), capacity(0), seq(0), batch(nullptr),
+    scratch_size(0), scratch(nullptr), code_pos(0), code(1) {
+}
+
+size_t FrameWriter::max_frame_size(size_t payload_size) {
+    // COBS adds one byte per 254 bytes, plus the leading code and the delimiter.
+    size_t size = AN_FRAME_HEADER_SIZE + payload_size + AN_FRAME_CRC_SIZE;
+    return size + (size / 254) + 2;
+}
+
+bool FrameWriter::reserve(size_t size) {
+    // Make sure there's enough room in the batch buffer to encode a frame.
+    if ((capacity - length) >= size) {
+        return true;
+    }
+
+    // Not enough space left, send the pending frames first.
+    flush();
+
+    if (capacity < size || capacity < batch_size) {
+        capacity = (size > batch_size) ? size : batch_size;
+        batch.reset(new uint8_t[capacity]);
+        if (!batch) {
+            capacity = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrameWriter::cobs_begin() {
+    code_pos = length++;
+    code = 1;
+}
+
+void FrameWriter::cobs_put(const uint8_t *data, size_t size) {
+    uint8_t *dst = batch.get();
+    for (size_t i=0; i<size; i++) {
+        if (data[i] == 0) {
+            dst[code_pos] = code;
+            code_pos = length++;
+            code = 1;
+        } else {
+            dst[length++] = data[i];
+            if (++code == 0xFF) {
+                dst[code_pos] = code;
+                code_pos = length++;
+                code = 1;
+            }
+        }
+    }
+}
+
+void FrameWriter::cobs_end() {
+    batch[code_pos] = code;
+    batch[length++] = 0;
+}
+
+size_t FrameWriter::write(const uint8_t *payload, size_t size, uint32_t channels,
+        uint32_t timestamp, uint32_t flags, uint32_t encoding) {
+    size_t frame_size = max_frame_size(size);
+    if (!reserve(frame_size)) {
+        return 0;
+    }
+
+    uint8_t hdr[AN_FRAME_HEADER_SIZE];
+    hdr[0] = AN_FRAME_VERSION;
+    hdr[1] = channels;
+    hdr[2] = flags;
+    hdr[3] = encoding;
+    put_le32(&hdr[4], seq++);
+    put_le32(&hdr[8], timestamp);
+    put_le32(&hdr[12], size);
+
+    uint8_t crc[AN_FRAME_CRC_SIZE];
+    put_le32(crc, an_crc32(an_crc32(0, hdr, sizeof(hdr)), payload, size));
+
+    size_t start = length;
+    cobs_begin();
+    cobs_put(hdr, sizeof(hdr));
+    cobs_put(payload, size);
+    cobs_put(crc, sizeof(crc));
+    cobs_end();
+    frame_size = length - start;
+
+    // Only hand the data to the output once a full batch is available,
+    // large writes are much cheaper than many small ones on USB CDC.
+    if (length >= batch_size) {
+        flush();
+    }
+    return frame_size;
+}
+
+size_t FrameWriter::write(SampleBuffer buf) {
+    uint32_t flags = 0;
+    if (buf.getflags(DMA_BUFFER_DISCONT)) {
+        flags |= AN_FRAME_DISCONT;
+    }
+    if (buf.getflags(DMA_BUFFER_INTRLVD)) {
+        flags |= AN_FRAME_INTRLVD;
+    }
+    if (encoding == AN_FRAME_RICE && buf.channels()) {
+        size_t n_samples = buf.size() / buf.channels();
+        size_t size = RiceCodec::max_size(n_samples, buf.channels());
+        if (scratch_size < size) {
+            scratch.reset(new uint8_t[size]);
+            scratch_size = scratch ? size : 0;
+        }
+        size = RiceCodec::encode(buf, scratch.get(), scratch_size);
+        if (size == 0) {
+            return 0;
+        }
+        return write(scratch.get(), size, buf.channels(), buf.timestamp(), flags, AN_FRAME_RICE);
+    }
+    // NOTE: Samples are stored little-endian, so they're sent as is.
+    return write((const uint8_t *) buf.data(), buf.bytes(), buf.channels(), buf.timestamp(), flags);
+}
+
+size_t FrameWriter::flush() {
+    size_t n = 0;
+    while (n < length) {
+        size_t ret = out.write(&batch[n], length - n);
+        if (ret == 0) {
+            break;
+        }
+        n += ret;
+    }
+    length = 0;
+    return n;
+}
@@ -0,0 +1,90 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __FRAME_WRITER_H__
+#define __FRAME_WRITER_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+// Binary frame format (all fields little-endian), before COBS encoding:
+//
+//  Offset  Size  Field
+//  0       1     Version (AN_FRAME_VERSION).
+//  1       1     Number of interleaved channels.
+//  2       1     Frame flags (AN_FRAME_DISCONT, ...).
+//  3       1     Payload encoding (AN_FRAME_RAW16, ...).
+//  4       4     Sequence number, incremented for every frame.
+//  8       4     Buffer timestamp.
+//  12      4     Payload length in bytes.
+//  16      N     Payload.
+//  16+N    4     CRC-32 (IEEE 802.3) of all the preceding bytes.
+//
+// Each frame is COBS encoded and terminated with a 0x00 delimiter, so a
+// receiver can resynchronize on any zero byte. See extras/tools/frame_decoder.py.
+#define AN_FRAME_VERSION        (1)
+#define AN_FRAME_HEADER_SIZE    (16)
+#define AN_FRAME_CRC_SIZE       (4)
+
+enum {
+    AN_FRAME_DISCONT    = (1 << 0),
+    AN_FRAME_INTRLVD    = (1 << 1),
+};
+
+enum {
+    AN_FRAME_RAW16      = 0U,
+    AN_FRAME_RICE       = 1U,   // Payload is a RiceCodec block.
+};
+
+class FrameWriter {
+    private:
+        Print &out;
+        size_t batch_size;
+        uint32_t encoding;
+        size_t length;
+        size_t capacity;
+        uint32_t seq;
+        std::unique_ptr<uint8_t[]> batch;
+        size_t scratch_size;
+        std::unique_ptr<uint8_t[]> scratch;
+
+        // COBS encoder state.
+        size_t code_pos;
+        uint8_t code;
+
+        bool reserve(size_t size);
+        void cobs_begin();
+        void cobs_put(const uint8_t *data, size_t size);
+        void cobs_end();
+
+    public:
+        FrameWriter(Print &out, size_t batch_size=4096, uint32_t encoding=AN_FRAME_RAW16);
+        size_t write(SampleBuffer buf);
+        size_t write(const uint8_t *payload, size_t size, uint32_t channels,
+                uint32_t timestamp, uint32_t flags=0, uint32_t encoding=AN_FRAME_RAW16);
+        size_t flush();
+        uint32_t sequence() {
+            return seq;
+        }
+        static size_t max_frame_size(size_t payload_size);
+};
+
+uint32_t an_crc32(uint32_t crc, const uint8_t *data, size_t size);
+
+#endif  // __FRAME_WRITER_H__
@@ -0,0 +1,144 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "FrequencyMeter.h"
+
+int FrequencyMeter::begin(float sample_rate, int32_t hysteresis, int32_t level) {
+    // A negative level, or a zero hysteresis, follow the signal.
+    if (sample_rate <= 0.0f || hysteresis < 0) {
+        return 0;
+    }
+    this->sample_rate = sample_rate;
+    this->hysteresis = hysteresis;
+    this->level = level;
+    reset(0);
+    return 1;
+}
+
+void FrequencyMeter::reset(size_t n_channels) {
+    for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+        zc_state_t *zc = &state[c];
+        zc->armed = false;
+        zc->crossed = false;
+        zc->level = level;
+        zc->hysteresis = hysteresis;
+        zc->period = 0.0f;
+        zc->phase = 0.0f;
+    }
+    this->n_channels = n_channels;
+    n_frames = 0;
+}
+
+void FrequencyMeter::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    if (sample_rate == 0.0f || n_channels == 0 || n_channels > AN_MAX_ADC_CHANNELS) {
+        return;
+    }
+
+    if (n_channels != this->n_channels || buf.getflags(DMA_BUFFER_DISCONT)) {
+        // Crossings can't be tracked across dropped samples.
+        reset(n_channels);
+    }
+
+    const Sample *data = buf.data();
+    size_t size = buf.size();
+    uint32_t n_frames = size / n_channels;
+    for (size_t c=0; c<n_channels; c++) {
+        zc_state_t *zc = &state[c];
+        bool learn = (zc->level < 0);
+        int32_t level = zc->level;
+        int32_t lower = level - (zc->hysteresis ? zc->hysteresis : 1);
+        int32_t prev = zc->prev;
+        int32_t lo = INT32_MAX, hi = INT32_MIN;
+        bool armed = zc->armed;
+        uint32_t first_idx = zc->last_idx;
+        float first_frac = zc->last_frac;
+        bool crossed = zc->crossed;
+        uint32_t n_periods = 0;
+
+        for (size_t i=c, n=0; i<size; i+=n_channels, n++) {
+            int32_t x = data[i];
+            lo = (x < lo) ? x : lo;
+            hi = (x > hi) ? x : hi;
+            if (x < lower) {
+                armed = true;
+            } else if (armed && x >= level && !learn) {
+                // Rising crossing between the previous sample and this one.
+                armed = false;
+                uint32_t idx = this->n_frames + n - 1;
+                float frac = (x != prev) ? (float) (level - prev) / (x - prev) : 0.0f;
+                if (!crossed) {
+                    first_idx = idx;
+                    first_frac = frac;
+                    crossed = true;
+                } else {
+                    n_periods++;
+                }
+                zc->last_idx = idx;
+                zc->last_frac = frac;
+            }
+            prev = x;
+        }
+
+        if (n_periods) {
+            // Average period over the crossings, including the last one of the previous buffer.
+            zc->period = ((float) (zc->last_idx - first_idx) + (zc->last_frac - first_frac)) / n_periods;
+        }
+        if (zc->period > 0.0f && (this->n_frames + n_frames - 1 - zc->last_idx) > 2.0f * zc->period) {
+            // No crossing for more than two periods: the signal stopped, and the
+            // next crossing starts a new measurement.
+            zc->period = 0.0f;
+            zc->phase = 0.0f;
+            crossed = false;
+        }
+        if (zc->period > 0.0f && crossed) {
+            // Phase of the last sample, 0 at the rising crossing.
+            float elapsed = (float) (this->n_frames + n_frames - 1 - zc->last_idx) - zc->last_frac;
+            zc->phase = fmodf(360.0f * elapsed / zc->period, 360.0f);
+        }
+
+        if (this->level < 0) {
+            zc->level = (lo + hi) / 2;
+        }
+        if (hysteresis == 0) {
+            zc->hysteresis = (hi - lo) / 8;
+        }
+        zc->prev = prev;
+        zc->armed = armed;
+        zc->crossed = crossed;
+    }
+    this->n_frames += n_frames;
+}
+
+float FrequencyMeter::frequency(size_t channel) {
+    // Returns the frequency in Hz, 0 if not measured yet.
+    if (channel >= n_channels || state[channel].period == 0.0f) {
+        return 0.0f;
+    }
+    return sample_rate / state[channel].period;
+}
+
+float FrequencyMeter::phase(size_t channel) {
+    // Returns the phase of the last sample in degrees, 0 at the rising crossing.
+    if (channel >= n_channels) {
+        return 0.0f;
+    }
+    return state[channel].phase;
+}
@@ -0,0 +1,72 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __FREQUENCY_METER_H__
+#define __FREQUENCY_METER_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "Pipeline.h"
+
+struct zc_state_t {
+    int32_t prev;           // Last sample of the previous buffer.
+    bool armed;             // Signal went below the lower threshold.
+    bool crossed;           // A crossing was seen since the last reset.
+    uint32_t last_idx;      // Last rising crossing, frame index and fraction.
+    float last_frac;
+    int32_t level;
+    int32_t hysteresis;
+    int32_t lo;
+    int32_t hi;
+    float period;           // In samples, 0 if not measured yet.
+    float phase;
+};
+
+// Measures frequency and phase per channel from rising zero crossings, with
+// hysteresis and linear interpolation between samples. Crossings are tracked
+// across buffers, and the period is averaged over the crossings in each buffer.
+// The period is cleared when there's no crossing for more than two periods.
+// The crossing level and hysteresis can be set, or follow the middle and 1/8
+// of the signal's range in the previous buffer. As a pipeline stage, buffers
+// are passed on unchanged.
+class FrequencyMeter : public PipelineStage {
+    private:
+        float sample_rate;
+        int32_t level;
+        int32_t hysteresis;
+        size_t n_channels;
+        uint32_t n_frames;      // Frame index of the next buffer.
+        zc_state_t state[AN_MAX_ADC_CHANNELS];
+
+        void reset(size_t n_channels);
+
+    public:
+        FrequencyMeter(): sample_rate(0), level(-1), hysteresis(0), n_channels(0), n_frames(0) {
+        }
+        int begin(float sample_rate, int32_t hysteresis=0, int32_t level=-1);
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        float frequency(size_t channel);
+        float phase(size_t channel);
+};
+
+#endif  // __FREQUENCY_METER_H__
@@ -0,0 +1,120 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "Goertzel.h"
+
+int GoertzelBank::begin(float sample_rate, size_t n_tones, const float *tones) {
+    if (sample_rate <= 0.0f || n_tones == 0 || n_tones > AN_MAX_GOERTZEL_TONES || tones == nullptr) {
+        return 0;
+    }
+
+    for (size_t i=0; i<n_tones; i++) {
+        if (tones[i] <= 0.0f || tones[i] >= (sample_rate / 2)) {
+            return 0;
+        }
+    }
+
+    for (size_t i=0; i<n_tones; i++) {
+        // Tones above fs/4 are measured at fs/2 - f on a modulated signal.
+        float f = tones[i];
+        mirrored[i] = (f > (sample_rate / 4));
+        if (mirrored[i]) {
+            f = (sample_rate / 2) - f;
+        }
+        // 2 - coeff = 2 - 2 * cos(w) = 4 * sin(w/2)^2, which keeps its precision
+        // for low tones, where coeff itself is close to 2.
+        float h = sinf((float) PI * f / sample_rate);
+        this->tones[i] = tones[i];
+        deltas[i] = (uint32_t) (4.0f * h * h * (1UL << AN_GOERTZEL_COEFF_BITS) + 0.5f);
+        // Cosine and sine of the quantized w, for the magnitude.
+        cosines[i] = deltas[i] / (2.0f * (1UL << AN_GOERTZEL_COEFF_BITS));
+        sines[i] = sqrtf(cosines[i] * (2.0f - cosines[i]));
+    }
+    this->n_tones = n_tones;
+    this->sample_rate = sample_rate;
+    n_channels = 0;
+    n_blocks = 0;
+    memset(mags, 0, sizeof(mags));
+    return 1;
+}
+
+void GoertzelBank::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    size_t n_frames = buf.size() / (n_channels ? n_channels : 1);
+    if (n_tones == 0 || n_frames == 0 || n_frames > AN_MAX_GOERTZEL_FRAMES || n_channels > AN_MAX_ADC_CHANNELS) {
+        return;
+    }
+
+    const Sample *data = buf.data();
+    if (n_channels != this->n_channels) {
+        // First block, or the channels changed: start from the first sample.
+        for (size_t c=0; c<n_channels; c++) {
+            offsets[c] = data[c];
+        }
+        this->n_channels = n_channels;
+    }
+
+    for (size_t c=0; c<n_channels; c++) {
+        int32_t offset = offsets[c];
+        int64_t sum = 0;
+        for (size_t t=0; t<n_tones; t++) {
+            // s[n] = x[n] + coeff * s[n-1] - s[n-2], with coeff = 2 - delta.
+            // The state grows to about n_frames * x / sin(w), which needs 64 bits.
+            int64_t delta = deltas[t];
+            int32_t sign = 1, step = mirrored[t] ? -1 : 1;
+            int64_t s1 = 0, s2 = 0;
+            for (size_t i=c; i<buf.size(); i+=n_channels) {
+                int64_t s0 = ((int32_t) data[i] - offset) * sign + 2 * s1 - s2 - ((delta * s1) >> AN_GOERTZEL_COEFF_BITS);
+                s2 = s1;
+                s1 = s0;
+                sign *= step;
+            }
+            // X = s1 - s2 * cos(w) + j * s2 * sin(w), scaled to the tone's amplitude.
+            // s1 - s2 is exact, so the real part doesn't lose precision for low tones.
+            float re = (float) (s1 - s2) + (float) s2 * cosines[t];
+            float im = (float) s2 * sines[t];
+            mags[c][t] = 2.0f * sqrtf(re * re + im * im) / n_frames;
+        }
+
+        // Estimate the DC offset for the next block.
+        for (size_t i=c; i<buf.size(); i+=n_channels) {
+            sum += data[i];
+        }
+        offsets[c] = sum / n_frames;
+    }
+    n_blocks++;
+}
+
+float GoertzelBank::magnitude(size_t channel, size_t tone) {
+    // Returns the amplitude of the tone in the last block, in ADC counts.
+    if (channel >= n_channels || tone >= n_tones) {
+        return 0.0f;
+    }
+    return mags[channel][tone];
+}
+
+float GoertzelBank::frequency(size_t tone) {
+    // Returns the frequency the filter of a tone is tuned to, after quantization.
+    if (tone >= n_tones) {
+        return 0.0f;
+    }
+    float f = asinf(sqrtf(deltas[tone] / 4.0f / (1UL << AN_GOERTZEL_COEFF_BITS))) * sample_rate / (float) PI;
+    return mirrored[tone] ? (sample_rate / 2) - f : f;
+}
@@ -0,0 +1,70 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __GOERTZEL_H__
+#define __GOERTZEL_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "Pipeline.h"
+
+#define AN_MAX_GOERTZEL_TONES   (8)
+#define AN_GOERTZEL_COEFF_BITS  (30)
+#define AN_MAX_GOERTZEL_FRAMES  (32768)
+
+// Goertzel filter bank: measures the amplitude of a few frequencies per block
+// and per channel, at a fraction of the cost of an FFT. Coefficients are
+// computed from the sample rate passed to begin(), which should be the rate
+// the ADC achieved (see AdvancedADC::rate()), and target frequencies don't
+// need to be multiples of the block's frequency resolution. The filters run
+// in fixed point, with the DC offset of each channel estimated from the
+// previous block. To keep low tones in tune, the recursion uses 2 - coeff in
+// Q30, and tones above fs/4 are mirrored below it by negating odd samples.
+// As a pipeline stage, buffers are passed on unchanged.
+class GoertzelBank : public PipelineStage {
+    private:
+        size_t n_tones;
+        float sample_rate;
+        float tones[AN_MAX_GOERTZEL_TONES];
+        uint32_t deltas[AN_MAX_GOERTZEL_TONES];    // 2 - 2 * cos(w) in Q30, w <= pi/2.
+        float cosines[AN_MAX_GOERTZEL_TONES];     // 1 - cos(w).
+        float sines[AN_MAX_GOERTZEL_TONES];
+        bool mirrored[AN_MAX_GOERTZEL_TONES];
+        float mags[AN_MAX_ADC_CHANNELS][AN_MAX_GOERTZEL_TONES];
+        int32_t offsets[AN_MAX_ADC_CHANNELS];
+        size_t n_channels;
+        uint32_t n_blocks;
+
+    public:
+        GoertzelBank(): n_tones(0), sample_rate(0), n_channels(0), n_blocks(0) {
+        }
+        int begin(float sample_rate, size_t n_tones, const float *tones);
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        float magnitude(size_t channel, size_t tone);
+        float frequency(size_t tone);
+        uint32_t blocks() {
+            return n_blocks;
+        }
+};
+
+#endif  // __GOERTZEL_H__
@@ -29,6 +29,13 @@ static uint32_t hal_tim_freq(TIM_HandleTypeDef *tim) {
     }
 }
 
+float hal_tim_get_frequency(TIM_HandleTypeDef *tim) {
+    // Returns the actual update frequency, which may differ from the requested
+    // frequency due to the integer prescaler and period. The registers are used,
+    // so this also works with a handle to a timer configured elsewhere.
+    return (float) hal_tim_freq(tim) / ((tim->Instance->PSC + 1) * (tim->Instance->ARR + 1));
+}
+
 int hal_tim_config(TIM_HandleTypeDef *tim, uint32_t t_freq) {
     uint32_t t_clk = hal_tim_freq(tim);
     uint32_t t_div = ((t_clk / t_freq) > 0xFFFF) ? 64000 : (t_freq * 2);
@@ -97,7 +104,7 @@ int hal_dma_config(DMA_HandleTypeDef *dma, IRQn_Type irqn, uint32_t direction) {
     return 0;
 }
 
-void hal_dma_enable_dbm(DMA_HandleTypeDef *dma, void *m0, void *m1) {
+void hal_dma_enable_dbm(DMA_HandleTypeDef *dma, void *m0, void *m1, bool half_xfer) {
     // NOTE: This is a workaround for the ADC/DAC HAL driver lacking a function to start DMA
     // in double/multi buffer mode. The HAL_x_DMA_Start function clears the double buffer bit,
     // so we disable the stream, re-set the DMB bit, and re-enable the stream. This should be
@@ -119,6 +126,14 @@ void hal_dma_enable_dbm(DMA_HandleTypeDef *dma, void *m0, void *m1) {
     // Set the second buffer transfer complete callback.
     dma->XferM1CpltCallback = dma->XferCpltCallback;
 
+    if (half_xfer) {
+        // Set the second buffer half transfer callback.
+        dma->XferM1HalfCpltCallback = dma->XferHalfCpltCallback;
+    } else {
+        // Disable the half transfer interrupt if it's not used.
+        ((DMA_Stream_TypeDef *) dma->Instance)->CR &= ~(DMA_SxCR_HTIE);
+    }
+
     __HAL_DMA_ENABLE(dma);
 }
 
@@ -127,6 +142,24 @@ size_t hal_dma_get_ct(DMA_HandleTypeDef *dma) {
     return !!(((DMA_Stream_TypeDef *) dma->Instance)->CR & DMA_SxCR_CT);
 }
 
+size_t hal_dma_get_ndtr(DMA_HandleTypeDef *dma) {
+    // Returns the number of transfers remaining in the current target buffer.
+    return ((DMA_Stream_TypeDef *) dma->Instance)->NDTR;
+}
+
+size_t hal_dma_get_fifo_level(DMA_HandleTypeDef *dma) {
+    // Returns the maximum number of bytes held in the 16 bytes FIFO, which have
+    // been transferred from the peripheral but not yet written to memory.
+    switch (((DMA_Stream_TypeDef *) dma->Instance)->FCR & DMA_SxFCR_FS) {
+        case DMA_FIFOSTATUS_EMPTY:              return 0;
+        case DMA_FIFOSTATUS_LESS_1QUARTER_FULL: return 3;
+        case DMA_FIFOSTATUS_1QUARTER_FULL:      return 7;
+        case DMA_FIFOSTATUS_HALF_FULL:          return 11;
+        case DMA_FIFOSTATUS_3QUARTERS_FULL:     return 15;
+        default:                                return 16;
+    }
+}
+
 void hal_dma_update_memory(DMA_HandleTypeDef *dma, void *addr) {
     // Update the next DMA target pointer.
     if (((DMA_Stream_TypeDef *) dma->Instance)->CR & DMA_SxCR_CT) {
@@ -166,6 +199,14 @@ static uint32_t ADC_RANK_LUT[] = {
     ADC_REGULAR_RANK_1, ADC_REGULAR_RANK_2, ADC_REGULAR_RANK_3, ADC_REGULAR_RANK_4, ADC_REGULAR_RANK_5
 };
 
+// Sampling time of all channels, in ADC clock cycles: ADC_SAMPLING_CYCLES must match.
+#define ADC_SAMPLING_TIME   ADC_SAMPLETIME_8CYCLES_5
+#define ADC_SAMPLING_CYCLES (8.5f)
+// Internal channels need a longer sampling time: at least 9us for the
+// temperature sensor, and 4.3us for VREFINT.
+#define ADC_INTERNAL_SAMPLING_TIME      ADC_SAMPLETIME_810CYCLES_5
+#define ADC_INTERNAL_SAMPLING_CYCLES    (810.5f)
+
 int hal_adc_config(ADC_HandleTypeDef *adc, uint32_t resolution, uint32_t trigger, PinName *adc_pins, uint32_t n_channels) {
     // Set ADC clock source.
     __HAL_RCC_ADC_CONFIG(RCC_ADCCLKSOURCE_CLKP);
@@ -204,13 +245,27 @@ int hal_adc_config(ADC_HandleTypeDef *adc, uint32_t resolution, uint32_t trigger
     sConfig.Offset       = 0;
     sConfig.OffsetNumber = ADC_OFFSET_NONE;
     sConfig.SingleDiff   = ADC_SINGLE_ENDED;
-    sConfig.SamplingTime = ADC_SAMPLETIME_8CYCLES_5;
 
     for (size_t rank=0; rank<n_channels; rank++) {
-        uint32_t function = pinmap_function(adc_pins[rank], PinMap_ADC);
-        uint32_t channel = STM_PIN_CHANNEL(function);
-        sConfig.Rank     = ADC_RANK_LUT[rank];
-        sConfig.Channel  = __HAL_ADC_DECIMAL_NB_TO_CHANNEL(channel);
+        // The internal measurement paths are enabled by HAL_ADC_ConfigChannel.
+        sConfig.SamplingTime = ADC_INTERNAL_SAMPLING_TIME;
+        switch (adc_pins[rank]) {
+            case ADC_TEMP:
+                sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
+                break;
+            case ADC_VREF:
+                sConfig.Channel = ADC_CHANNEL_VREFINT;
+                break;
+            case ADC_VBAT:
+                sConfig.Channel = ADC_CHANNEL_VBAT;
+                break;
+            default:
+                uint32_t function = pinmap_function(adc_pins[rank], PinMap_ADC);
+                sConfig.Channel = __HAL_ADC_DECIMAL_NB_TO_CHANNEL(STM_PIN_CHANNEL(function));
+                sConfig.SamplingTime = ADC_SAMPLING_TIME;
+                break;
+        }
+        sConfig.Rank = ADC_RANK_LUT[rank];
         if (HAL_ADC_ConfigChannel(adc, &sConfig) != HAL_OK) {
             return -1;
         }
@@ -218,3 +273,28 @@ int hal_adc_config(ADC_HandleTypeDef *adc, uint32_t resolution, uint32_t trigger
 
     return 0;
 }
+
+float hal_adc_get_conversion_time(ADC_HandleTypeDef *adc, PinName pin) {
+    // Returns the time taken to convert the channel of a pin, i.e. the delay
+    // between its sample and the next rank's in the scan sequence, in seconds.
+    float f_adc = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_ADC);
+    if (HAL_GetREVID() > REV_ID_Y) {
+        // Revision V and later divide the asynchronous clock by 2.
+        f_adc /= 2;
+    }
+    if (f_adc == 0.0f) {
+        return 0.0f;
+    }
+
+    // Successive approximation cycles, depending on the resolution.
+    float sar_cycles;
+    switch (adc->Init.Resolution) {
+        case ADC_RESOLUTION_8B:  sar_cycles = 4.5f; break;
+        case ADC_RESOLUTION_10B: sar_cycles = 5.5f; break;
+        case ADC_RESOLUTION_12B: sar_cycles = 6.5f; break;
+        case ADC_RESOLUTION_14B: sar_cycles = 7.5f; break;
+        default:                 sar_cycles = 8.5f; break;
+    }
+    bool internal = (pin == ADC_TEMP || pin == ADC_VREF || pin == ADC_VBAT);
+    return ((internal ? ADC_INTERNAL_SAMPLING_CYCLES : ADC_SAMPLING_CYCLES) + sar_cycles) / f_adc;
+}
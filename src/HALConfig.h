@@ -24,11 +24,15 @@
 #include "AdvancedAnalog.h"
 
 int hal_tim_config(TIM_HandleTypeDef *tim, uint32_t t_freq);
+float hal_tim_get_frequency(TIM_HandleTypeDef *tim);
 int hal_dma_config(DMA_HandleTypeDef *dma, IRQn_Type irqn, uint32_t direction);
 size_t hal_dma_get_ct(DMA_HandleTypeDef *dma);
-void hal_dma_enable_dbm(DMA_HandleTypeDef *dma, void *m0 = nullptr, void *m1 = nullptr);
+size_t hal_dma_get_ndtr(DMA_HandleTypeDef *dma);
+size_t hal_dma_get_fifo_level(DMA_HandleTypeDef *dma);
+void hal_dma_enable_dbm(DMA_HandleTypeDef *dma, void *m0 = nullptr, void *m1 = nullptr, bool half_xfer = true);
 void hal_dma_update_memory(DMA_HandleTypeDef *dma, void *addr);
 int hal_dac_config(DAC_HandleTypeDef *dac, uint32_t channel, uint32_t trigger);
 int hal_adc_config(ADC_HandleTypeDef *adc, uint32_t resolution, uint32_t trigger, PinName *adc_pins, uint32_t n_channels);
+float hal_adc_get_conversion_time(ADC_HandleTypeDef *adc, PinName pin);
 
 #endif  // __HAL_CONFIG_H__
@@ -0,0 +1,121 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "LockIn.h"
+
+int LockIn::begin(float sample_rate, uint32_t phase, uint32_t step, size_t decimation, float bandwidth, size_t depth) {
+    // The phase and step are those of the first input sample.
+    if (sample_rate <= 0.0f || step == 0 || decimation == 0 || depth == 0
+     || bandwidth <= 0.0f || bandwidth >= (sample_rate / 2)) {
+        return 0;
+    }
+
+    outputs.reset();
+    if (!outputs.resize(depth)) {
+        return 0;
+    }
+    this->sample_rate = sample_rate;
+    ref_phase = phase;
+    ref_step = step;
+    alpha = 1.0f - expf(-2.0f * (float) PI * bandwidth / sample_rate);
+    this->decimation = decimation;
+    count = 0;
+    n_channels = 0;
+    n_samples = 0;
+    n_dropped = 0;
+    return 1;
+}
+
+void LockIn::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    size_t n_frames = buf.size() / (n_channels ? n_channels : 1);
+    if (decimation == 0 || n_channels == 0 || n_channels > AN_MAX_ADC_CHANNELS) {
+        return;
+    }
+
+    const Sample *data = buf.data();
+    if (n_channels != this->n_channels) {
+        // First buffer: start the filters from zero and remove the first samples.
+        for (size_t c=0; c<n_channels; c++) {
+            offsets[c] = data[c];
+        }
+        memset(state, 0, sizeof(state));
+        this->n_channels = n_channels;
+    }
+
+    if (buf.getflags(DMA_BUFFER_DISCONT)) {
+        // The number of samples dropped is not known, so the reference can't
+        // follow: amplitudes stay valid, but phases are offset from now on.
+        n_dropped++;
+    }
+
+    uint32_t phase = ref_phase + n_samples * ref_step;
+    for (size_t i=0; i<n_frames; i++, phase+=ref_step) {
+        float s = DDS::sine(phase) * (2.0f / 32767);
+        float co = DDS::cosine(phase) * (2.0f / 32767);
+        for (size_t c=0; c<n_channels; c++) {
+            // For x = A * sin(wt + theta), x * 2 * sin(wt) and x * 2 * cos(wt)
+            // average to X = A * cos(theta) and Y = A * sin(theta).
+            float x = data[i * n_channels + c] - offsets[c];
+            float *st = state[c];
+            st[0] += alpha * (x * s - st[0]);
+            st[1] += alpha * (x * co - st[1]);
+            st[2] += alpha * (st[0] - st[2]);
+            st[3] += alpha * (st[1] - st[3]);
+        }
+
+        if (++count == decimation) {
+            LockInSample out;
+            for (size_t c=0; c<n_channels; c++) {
+                float *st = state[c];
+                out.amplitude[c] = sqrtf(st[2] * st[2] + st[3] * st[3]);
+                // Channel c is sampled delays[c] after the first one.
+                float theta = atan2f(st[3], st[2]) * 180.0f / (float) PI
+                            - 360.0f * ref_step / 4294967296.0f * sample_rate * delays[c];
+                theta = fmodf(theta, 360.0f);
+                out.phase[c] = (theta > 180.0f) ? theta - 360.0f : (theta <= -180.0f) ? theta + 360.0f : theta;
+            }
+            out.index = n_samples + i;
+            // The oldest outputs are kept if the consumer falls behind.
+            outputs.push(out);
+            count = 0;
+        }
+    }
+
+    // Track the DC offset to keep the products small.
+    for (size_t c=0; c<n_channels; c++) {
+        uint32_t sum = 0;
+        for (size_t i=c; i<buf.size(); i+=n_channels) {
+            sum += data[i];
+        }
+        offsets[c] = (float) sum / n_frames;
+    }
+    n_samples += n_frames;
+}
+
+size_t LockIn::available() {
+    // Number of outputs ready.
+    return outputs.size();
+}
+
+LockInSample LockIn::read() {
+    // Returns the oldest output, or zeros if none is available.
+    return outputs.pop();
+}
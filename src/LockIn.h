@@ -0,0 +1,90 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __LOCK_IN_H__
+#define __LOCK_IN_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "AdvancedADC.h"
+#include "Pipeline.h"
+#include "DDS.h"
+
+struct LockInSample {
+    float amplitude[AN_MAX_ADC_CHANNELS];   // In ADC counts.
+    float phase[AN_MAX_ADC_CHANNELS];       // In degrees, relative to the reference.
+    uint32_t index;                         // Index of the last input sample.
+};
+
+// Digital lock-in amplifier: multiplies each channel by in-phase and quadrature
+// references, low-pass filters the products with two one-pole filters, and
+// outputs the amplitude and phase every few samples. The reference is a DDS
+// phase and step: the phase of input sample n is phase + n * step, so using
+// the DDS that drives a DAC, with the ADC triggered by the DAC (see
+// AdvancedADC::trigger()), aligns the reference with the stimulus by sample
+// index. As a pipeline stage, buffers are passed on unchanged.
+class LockIn : public PipelineStage {
+    private:
+        float sample_rate;
+        uint32_t ref_phase;
+        uint32_t ref_step;
+        float delays[AN_MAX_ADC_CHANNELS];     // Sample time of each channel after the first.
+        float alpha;
+        size_t decimation;
+        size_t count;
+        size_t n_channels;
+        uint32_t n_samples;
+        uint32_t n_dropped;
+        float offsets[AN_MAX_ADC_CHANNELS];
+        float state[AN_MAX_ADC_CHANNELS][4];    // Two filter stages for X and Y.
+        Queue<LockInSample> outputs;
+
+    public:
+        LockIn(): sample_rate(0), ref_phase(0), ref_step(0), delays(), alpha(0), decimation(0),
+            count(0), n_channels(0), n_samples(0), n_dropped(0) {
+        }
+        int begin(float sample_rate, uint32_t phase, uint32_t step, size_t decimation, float bandwidth, size_t depth=16);
+        int begin(DDS &dds, size_t decimation, float bandwidth, size_t depth=16) {
+            return begin(dds.rate(), dds.phase(), dds.step(), decimation, bandwidth, depth);
+        }
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        void skew(float skew) {
+            // Delay between successive channels in seconds, see AdvancedADC::skew().
+            for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+                delays[c] = c * skew;
+            }
+        }
+        void skew(AdvancedADC &adc) {
+            // Delays of the channels of a running ADC, including internal channels.
+            for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+                delays[c] = adc.skew(c);
+            }
+        }
+        size_t available();
+        LockInSample read();
+        uint32_t dropped() {
+            return n_dropped;
+        }
+};
+
+#endif  // __LOCK_IN_H__
@@ -0,0 +1,585 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "Pipeline.h"
+
+#if defined(ARDUINO_ARCH_MBED)
+#include "mbed.h"
+#include "rtos.h"
+
+typedef rtos::Mutex pipeline_mutex_t;
+
+struct pipeline_thread_t {
+    void *owner;
+    size_t index;
+    rtos::Semaphore sem;
+    rtos::Thread thread;
+    bool started;
+
+    pipeline_thread_t(void *owner, size_t index, size_t stack_size):
+        owner(owner), index(index), sem(0, 1), thread(osPriorityNormal, stack_size), started(false) {
+    }
+    bool start(void (*fn)(pipeline_thread_t *)) {
+        started = (thread.start(mbed::callback(fn, this)) == osOK);
+        return started;
+    }
+    void notify() {
+        sem.release();
+    }
+    void wait(uint32_t ms) {
+        sem.try_acquire_for(std::chrono::milliseconds(ms));
+    }
+    void join() {
+        // Joining a thread that was never started blocks forever.
+        notify();
+        if (started) {
+            thread.join();
+            started = false;
+        }
+    }
+};
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+typedef std::mutex pipeline_mutex_t;
+
+struct pipeline_thread_t {
+    void *owner;
+    size_t index;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool signaled;
+    std::thread thread;
+
+    pipeline_thread_t(void *owner, size_t index, size_t stack_size):
+        owner(owner), index(index), signaled(false) {
+    }
+    bool start(void (*fn)(pipeline_thread_t *)) {
+        thread = std::thread(fn, this);
+        return true;
+    }
+    void notify() {
+        std::lock_guard<std::mutex> lock(mutex);
+        signaled = true;
+        cond.notify_one();
+    }
+    void wait(uint32_t ms) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait_for(lock, std::chrono::milliseconds(ms), [this] { return signaled; });
+        signaled = false;
+    }
+    void join() {
+        notify();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+#endif
+
+DMABuffer<Sample> *FilterStage::process(DMABuffer<Sample> *buf) {
+    size_t n_channels = buf->channels();
+    Sample *data = buf->data();
+    if (n_channels == 0 || n_channels > AN_MAX_ADC_CHANNELS) {
+        return buf;
+    }
+    if (n_channels != this->n_channels) {
+        // Restart from the first frame when the channels change.
+        for (size_t i=0; i<n_channels; i++) {
+            state[i] = data[i] << 8;
+        }
+        this->n_channels = n_channels;
+    }
+    // State is kept with 8 fractional bits.
+    for (size_t i=0; i<buf->size(); i+=n_channels) {
+        for (size_t j=0; j<n_channels; j++) {
+            state[j] += (((int32_t) data[i + j] << 8) - state[j]) >> shift;
+            data[i + j] = state[j] >> 8;
+        }
+    }
+    return buf;
+}
+
+DMABuffer<Sample> *ConvertStage::process(DMABuffer<Sample> *buf) {
+    Sample *data = buf->data();
+    if (shift > 0) {
+        for (size_t i=0; i<buf->size(); i++) {
+            data[i] <<= shift;
+        }
+    } else if (shift < 0) {
+        for (size_t i=0; i<buf->size(); i++) {
+            data[i] >>= -shift;
+        }
+    }
+    return buf;
+}
+
+DMABuffer<Sample> *DecimateStage::process(DMABuffer<Sample> *buf) {
+    size_t n_channels = buf->channels();
+    size_t n_frames = n_channels ? (buf->size() / n_channels / factor) : 0;
+    if (!pool && n_frames) {
+        // The pool is allocated for the largest buffers of the source.
+        pool.reset(new DMABufferPool<Sample>(buf->max_samples() / factor, n_channels, n_buffers));
+    }
+
+    // Output buffers have as many frames as the input, after decimation.
+    DMABuffer<Sample> *out = (pool && *pool && pool->samples(n_frames)) ? pool->allocate() : nullptr;
+    if (out == nullptr || out->channels() != n_channels) {
+        if (out) {
+            out->release();
+        }
+        buf->release();
+        return nullptr;
+    }
+
+    Sample *src = buf->data();
+    Sample *dst = out->data();
+    for (size_t i=0; i<n_frames; i++) {
+        for (size_t j=0; j<n_channels; j++) {
+            uint32_t sum = 0;
+            for (size_t k=0; k<factor; k++) {
+                sum += src[(i * factor + k) * n_channels + j];
+            }
+            dst[i * n_channels + j] = sum / factor;
+        }
+    }
+    out->timestamp(buf->timestamp());
+    out->setflags(buf->getflags(DMA_BUFFER_DISCONT) ? DMA_BUFFER_DISCONT : 0);
+    if (n_channels > 1) {
+        out->setflags(DMA_BUFFER_INTRLVD);
+    }
+    buf->release();
+    return out;
+}
+
+DMABuffer<Sample> *MixStage::process(DMABuffer<Sample> *buf) {
+    size_t n_channels = buf->channels();
+    if (n_channels <= 1) {
+        return buf;
+    }
+    size_t n_frames = buf->size() / n_channels;
+    if (!pool) {
+        // The pool is allocated for the largest buffers of the source.
+        pool.reset(new DMABufferPool<Sample>(buf->max_samples(), 1, n_buffers));
+    }
+
+    // Output buffers have as many frames as the input.
+    DMABuffer<Sample> *out = (pool && *pool && pool->samples(n_frames)) ? pool->allocate() : nullptr;
+    if (out == nullptr) {
+        buf->release();
+        return nullptr;
+    }
+
+    Sample *src = buf->data();
+    Sample *dst = out->data();
+    for (size_t i=0; i<n_frames; i++) {
+        uint32_t sum = 0;
+        for (size_t j=0; j<n_channels; j++) {
+            sum += src[i * n_channels + j];
+        }
+        dst[i] = sum / n_channels;
+    }
+    out->timestamp(buf->timestamp());
+    out->setflags(buf->getflags(DMA_BUFFER_DISCONT) ? DMA_BUFFER_DISCONT : 0);
+    buf->release();
+    return out;
+}
+
+Pipeline::Pipeline(size_t queue_size): n_stages(0), queue_size(queue_size ? queue_size : 1),
+    mode(AN_PIPELINE_INLINE), running(false) {
+    for (size_t i=0; i<AN_ARRAY_SIZE(threads); i++) {
+        threads[i] = nullptr;
+    }
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+int Pipeline::add(PipelineStage *stage, bool owner) {
+    if (stage == nullptr || running || n_stages == AN_MAX_PIPELINE_STAGES) {
+        if (owner) {
+            delete stage;
+        }
+        return 0;
+    }
+
+    queues[n_stages].reset(new Queue<DMABuffer<Sample>*>(queue_size));
+    if (!queues[n_stages] || !*queues[n_stages]) {
+        if (owner) {
+            delete stage;
+        }
+        return 0;
+    }
+
+    if (owner) {
+        owned[n_stages].reset(stage);
+    }
+    nodes[n_stages] = stage;
+    stage_stats[n_stages] = {};
+    n_stages++;
+    return 1;
+}
+
+int Pipeline::begin(uint32_t mode, size_t stack_size) {
+    if (running || !src || n_stages == 0) {
+        return 0;
+    }
+
+    this->mode = mode;
+    running = true;
+    if (mode == AN_PIPELINE_THREADED) {
+        // Thread 0 moves buffers from the source to the first queue,
+        // and thread i+1 runs stage i.
+        // All threads are created before any is started, since they wake each other up.
+        for (size_t i=0; i<(n_stages + 1); i++) {
+            threads[i] = new pipeline_thread_t(this, i, stack_size);
+            if (threads[i] == nullptr) {
+                stop();
+                return 0;
+            }
+        }
+        for (size_t i=0; i<(n_stages + 1); i++) {
+            if (!threads[i]->start(run)) {
+                stop();
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+void Pipeline::run(pipeline_thread_t *thread) {
+    Pipeline *pipeline = (Pipeline *) thread->owner;
+    while (pipeline->running) {
+        bool progress = (thread->index == 0) ? pipeline->pump() : pipeline->step(thread->index - 1);
+        if (!progress) {
+            // Woken up by the neighbouring stages, sources are polled.
+            thread->wait(1);
+        }
+    }
+}
+
+void Pipeline::wake(size_t i) {
+    // Wake up the thread for stage i (source is -1).
+    if (mode == AN_PIPELINE_THREADED && (i + 1) < AN_ARRAY_SIZE(threads) && threads[i + 1]) {
+        threads[i + 1]->notify();
+    }
+}
+
+bool Pipeline::pump() {
+    // Move one buffer from the source to the first stage.
+    if (queues[0]->size() >= queue_size || !src->available()) {
+        return false;
+    }
+    DMABuffer<Sample> *buf = src->read();
+    if (buf == nullptr) {
+        return false;
+    }
+    queues[0]->push(buf);
+    wake(0);
+    return true;
+}
+
+bool Pipeline::step(size_t i) {
+    // Run stage i on one buffer, if there's room for its output.
+    Queue<DMABuffer<Sample>*> *in = queues[i].get();
+    if (in->empty() || !nodes[i]->ready()) {
+        return false;
+    }
+
+    if ((i + 1) < n_stages && queues[i + 1]->size() >= queue_size) {
+        stage_stats[i].stalls++;
+        return false;
+    }
+
+    DMABuffer<Sample> *buf = in->pop();
+    size_t n_samples = buf->size();
+    uint32_t start = micros();
+    buf = nodes[i]->process(buf);
+    uint32_t elapsed = micros() - start;
+
+    PipelineStats *stats = &stage_stats[i];
+    stats->buffers++;
+    stats->samples += n_samples;
+    stats->busy_us += elapsed;
+    if (elapsed > stats->max_us) {
+        stats->max_us = elapsed;
+    }
+
+    if (buf != nullptr) {
+        if ((i + 1) < n_stages) {
+            queues[i + 1]->push(buf);
+            wake(i + 1);
+        } else {
+            // The last stage isn't a sink.
+            buf->release();
+        }
+    }
+    // There's room in this stage's queue now.
+    wake(i - 1);
+    return true;
+}
+
+size_t Pipeline::poll() {
+    // Move buffers as far as possible through the pipeline, returns the number
+    // of buffers processed. Only used in AN_PIPELINE_INLINE mode.
+    size_t count = 0;
+    if (!running || mode != AN_PIPELINE_INLINE) {
+        return 0;
+    }
+    while (pump()) {
+    }
+    for (size_t i=0; i<n_stages; i++) {
+        while (step(i)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int Pipeline::stop() {
+    running = false;
+    for (size_t i=0; i<AN_ARRAY_SIZE(threads); i++) {
+        if (threads[i]) {
+            threads[i]->join();
+            delete threads[i];
+            threads[i] = nullptr;
+        }
+    }
+
+    // Release any buffers left in the queues.
+    for (size_t i=0; i<n_stages; i++) {
+        while (!queues[i]->empty()) {
+            queues[i]->pop()->release();
+        }
+    }
+    return 1;
+}
+
+PipelineStats Pipeline::stats(size_t stage) {
+    if (stage >= n_stages) {
+        return {};
+    }
+    return stage_stats[stage];
+}
+
+struct sched_task_t {
+    uint32_t seq;
+    uint32_t key;
+};
+
+struct scheduler_worker_t {
+    // Ring deque of tasks: the owner takes tasks from the front, thieves from the back.
+    pipeline_thread_t thread;
+    pipeline_mutex_t mutex;
+    std::unique_ptr<sched_task_t[]> tasks;
+    size_t size;
+    size_t head;
+    size_t count;
+    std::atomic<uint32_t> processed;
+
+    scheduler_worker_t(void *owner, size_t index, size_t stack_size, size_t size):
+        thread(owner, index, stack_size), tasks(new sched_task_t[size]), size(size),
+        head(0), count(0), processed(0) {
+    }
+
+    bool push(sched_task_t task) {
+        mutex.lock();
+        bool ret = (tasks && count < size);
+        if (ret) {
+            tasks[(head + count++) % size] = task;
+        }
+        mutex.unlock();
+        return ret;
+    }
+
+    bool pop(sched_task_t *task) {
+        mutex.lock();
+        bool ret = (count > 0);
+        if (ret) {
+            *task = tasks[head];
+            head = (head + 1) % size;
+            count--;
+        }
+        mutex.unlock();
+        return ret;
+    }
+
+    bool steal(sched_task_t *task) {
+        // Tasks with a key are pinned to this worker, to keep their order.
+        mutex.lock();
+        bool ret = (count > 0 && tasks[(head + count - 1) % size].key == AN_SCHED_ANY);
+        if (ret) {
+            *task = tasks[(head + --count) % size];
+        }
+        mutex.unlock();
+        return ret;
+    }
+};
+
+static size_t sched_capacity(size_t capacity) {
+    // Slots are indexed by a 32-bit sequence number modulo the capacity, which
+    // only stays contiguous across the wrap for a power of two.
+    size_t n = 1;
+    while (n < capacity) {
+        n <<= 1;
+    }
+    return capacity ? n : 0;
+}
+
+BlockScheduler::BlockScheduler(PipelineStage &stage, size_t n_workers, size_t capacity):
+    stage(stage), n_workers(n_workers), capacity(sched_capacity(capacity)),
+    slots(this->capacity ? new sched_slot_t[this->capacity] : nullptr),
+    seq_in(0), seq_out(0), next_worker(0), running(false), n_stolen(0) {
+    if (this->n_workers > AN_MAX_SCHED_WORKERS) {
+        this->n_workers = AN_MAX_SCHED_WORKERS;
+    }
+    for (size_t i=0; i<AN_ARRAY_SIZE(workers); i++) {
+        workers[i] = nullptr;
+    }
+}
+
+BlockScheduler::~BlockScheduler() {
+    stop();
+}
+
+int BlockScheduler::begin(size_t stack_size) {
+    if (running || !slots || n_workers == 0) {
+        return 0;
+    }
+
+    for (size_t i=0; i<n_workers; i++) {
+        workers[i] = new scheduler_worker_t(this, i, stack_size, capacity);
+        if (workers[i] == nullptr || !workers[i]->tasks) {
+            stop();
+            return 0;
+        }
+    }
+
+    running = true;
+    for (size_t i=0; i<n_workers; i++) {
+        if (!workers[i]->thread.start(run)) {
+            stop();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void BlockScheduler::run(pipeline_thread_t *thread) {
+    BlockScheduler *sched = (BlockScheduler *) thread->owner;
+    scheduler_worker_t *self = sched->workers[thread->index];
+    while (sched->running) {
+        sched_task_t task;
+        bool found = self->pop(&task);
+        for (size_t i=1; !found && i<sched->n_workers; i++) {
+            // Steal from the other workers, starting with the next one.
+            found = sched->workers[(thread->index + i) % sched->n_workers]->steal(&task);
+            if (found) {
+                sched->n_stolen++;
+            }
+        }
+
+        if (!found) {
+            thread->wait(1);
+            continue;
+        }
+
+        sched_slot_t *slot = &sched->slots[task.seq % sched->capacity];
+        slot->buf = sched->stage.process(slot->buf);
+        slot->done.store(true, std::memory_order_release);
+        self->processed++;
+    }
+}
+
+bool BlockScheduler::submit(DMABuffer<Sample> *buf, uint32_t key) {
+    // Returns false if the scheduler is full, and the buffer wasn't taken.
+    if (!running || buf == nullptr || (seq_in - seq_out.load(std::memory_order_acquire)) >= capacity) {
+        return false;
+    }
+
+    sched_slot_t *slot = &slots[seq_in.load() % capacity];
+    slot->buf = buf;
+    slot->done.store(false, std::memory_order_relaxed);
+
+    size_t worker = (key == AN_SCHED_ANY) ? (next_worker++ % n_workers) : (key % n_workers);
+    if (!workers[worker]->push({seq_in.load(), key})) {
+        return false;
+    }
+    seq_in++;
+    workers[worker]->thread.notify();
+    return true;
+}
+
+DMABuffer<Sample> *BlockScheduler::next() {
+    // Returns the next processed buffer in submission order, or nullptr if it's
+    // not done yet. Buffers consumed by the stage are skipped.
+    uint32_t seq = seq_out.load(std::memory_order_relaxed);
+    while (seq != seq_in) {
+        sched_slot_t *slot = &slots[seq % capacity];
+        if (!slot->done.load(std::memory_order_acquire)) {
+            break;
+        }
+        DMABuffer<Sample> *buf = slot->buf;
+        slot->done.store(false, std::memory_order_relaxed);
+        seq_out.store(++seq, std::memory_order_release);
+        if (buf != nullptr) {
+            return buf;
+        }
+    }
+    return nullptr;
+}
+
+size_t BlockScheduler::pending() {
+    // Number of buffers submitted and not returned by next() yet.
+    return seq_in - seq_out.load(std::memory_order_acquire);
+}
+
+uint32_t BlockScheduler::processed(size_t worker) {
+    return (worker < n_workers && workers[worker]) ? workers[worker]->processed.load() : 0;
+}
+
+int BlockScheduler::stop() {
+    running = false;
+    for (size_t i=0; i<AN_ARRAY_SIZE(workers); i++) {
+        if (workers[i]) {
+            workers[i]->thread.join();
+        }
+    }
+
+    // Release the buffers that are still in flight, processed or not.
+    for (uint32_t seq=seq_out; seq!=seq_in; seq++) {
+        sched_slot_t *slot = &slots[seq % capacity];
+        if (slot->buf) {
+            slot->buf->release();
+        }
+        slot->done = false;
+    }
+    seq_out = seq_in.load();
+
+    for (size_t i=0; i<AN_ARRAY_SIZE(workers); i++) {
+        delete workers[i];
+        workers[i] = nullptr;
+    }
+    return 1;
+}
@@ -0,0 +1,268 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <atomic>
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "AdvancedDAC.h"
+
+#define AN_MAX_PIPELINE_STAGES  (8)
+#define AN_MAX_SCHED_WORKERS    (8)
+#define AN_SCHED_ANY            (0xFFFFFFFFU)
+
+enum {
+    AN_PIPELINE_INLINE      = 0U,   // Stages run from poll(), in the caller's context.
+    AN_PIPELINE_THREADED    = 1U,   // One thread per stage, RTOS threads or std::thread on the host.
+};
+
+struct PipelineStats {
+    uint32_t buffers;       // Buffers processed.
+    uint32_t samples;       // Samples processed.
+    uint32_t busy_us;       // Time spent processing buffers.
+    uint32_t max_us;        // Longest time spent processing one buffer.
+    uint32_t stalls;        // Times the stage waited for room in the next queue.
+};
+
+// Base class for processing stages and sinks. process() is called for each
+// input buffer, and returns the buffer to pass to the next stage: the same
+// buffer processed in place, a new buffer (the input buffer must then be
+// released), or nullptr if the buffer was consumed.
+class PipelineStage {
+    public:
+        virtual ~PipelineStage() {
+        }
+        virtual bool ready() {
+            // Returns false if the stage can't accept a buffer now.
+            return true;
+        }
+        virtual DMABuffer<Sample> *process(DMABuffer<Sample> *buf) = 0;
+};
+
+class PipelineSource {
+    public:
+        virtual ~PipelineSource() {
+        }
+        virtual bool available() = 0;
+        virtual DMABuffer<Sample> *read() = 0;
+};
+
+// Any source with AdvancedADC's available()/read() (AdvancedADC, SampleReplay, SyntheticADC).
+template <class S> class PipelineSourceAdapter : public PipelineSource {
+    private:
+        S &source;
+
+    public:
+        PipelineSourceAdapter(S &source): source(source) {
+        }
+        bool available() override {
+            return source.available();
+        }
+        DMABuffer<Sample> *read() override {
+            DMABuffer<Sample> *buf = &source.read();
+            return *buf ? buf : nullptr;
+        }
+};
+
+// Any sink with a write(SampleBuffer) method (SampleRecorder, FrameWriter).
+template <class S> class PipelineSink : public PipelineStage {
+    private:
+        S &sink;
+
+    public:
+        PipelineSink(S &sink): sink(sink) {
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            sink.write(*buf);
+            buf->release();
+            return nullptr;
+        }
+};
+
+// The DAC takes ownership of the buffer, and releases it back to its pool
+// once it's been played, so no copy is needed. The buffers are queued by the
+// DAC, so it must be started with n_buffers of at least the pipeline's queue
+// size, or better the source's number of buffers so every buffer in flight fits.
+template <> class PipelineSink<AdvancedDAC> : public PipelineStage {
+    private:
+        AdvancedDAC &dac;
+
+    public:
+        PipelineSink(AdvancedDAC &dac): dac(dac) {
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            dac.write(*buf);
+            return nullptr;
+        }
+};
+
+// One-pole low-pass filter, in place: y += (x - y) >> shift. Buffers with
+// more than AN_MAX_ADC_CHANNELS channels are passed on unfiltered.
+class FilterStage : public PipelineStage {
+    private:
+        uint32_t shift;
+        int32_t state[AN_MAX_ADC_CHANNELS];
+        size_t n_channels;
+
+    public:
+        FilterStage(uint32_t shift): shift(shift), n_channels(0) {
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override;
+};
+
+// Shifts samples left (positive) or right (negative), in place. For example,
+// -4 converts 16-bit ADC samples to 12-bit DAC samples.
+class ConvertStage : public PipelineStage {
+    private:
+        int shift;
+
+    public:
+        ConvertStage(int shift): shift(shift) {
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override;
+};
+
+// Averages every factor frames into one, into buffers from the stage's own pool,
+// which is sized for the largest input buffers of the source (see max_samples()).
+class DecimateStage : public PipelineStage {
+    private:
+        size_t factor;
+        size_t n_buffers;
+        std::unique_ptr<DMABufferPool<Sample>> pool;
+
+    public:
+        DecimateStage(size_t factor, size_t n_buffers=4): factor(factor ? factor : 1), n_buffers(n_buffers) {
+        }
+        bool ready() override {
+            return !pool || pool->writable();
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override;
+};
+
+// Mixes interleaved channels down to one channel, into buffers from the stage's own pool,
+// which is sized for the largest input buffers of the source (see max_samples()).
+class MixStage : public PipelineStage {
+    private:
+        size_t n_buffers;
+        std::unique_ptr<DMABufferPool<Sample>> pool;
+
+    public:
+        MixStage(size_t n_buffers=4): n_buffers(n_buffers) {
+        }
+        bool ready() override {
+            return !pool || pool->writable();
+        }
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override;
+};
+
+struct pipeline_thread_t;
+
+// Connects a source, processing stages, and a sink with bounded queues of
+// buffers. Buffers are passed between stages without copying.
+class Pipeline {
+    private:
+        std::unique_ptr<PipelineSource> src;
+        PipelineStage *nodes[AN_MAX_PIPELINE_STAGES];
+        std::unique_ptr<PipelineStage> owned[AN_MAX_PIPELINE_STAGES];
+        std::unique_ptr<Queue<DMABuffer<Sample>*>> queues[AN_MAX_PIPELINE_STAGES];
+        PipelineStats stage_stats[AN_MAX_PIPELINE_STAGES];
+        pipeline_thread_t *threads[AN_MAX_PIPELINE_STAGES + 1];
+        size_t n_stages;
+        size_t queue_size;
+        uint32_t mode;
+        std::atomic<bool> running;
+
+        int add(PipelineStage *stage, bool owner);
+        bool pump();
+        bool step(size_t i);
+        void wake(size_t i);
+        static void run(pipeline_thread_t *thread);
+
+    public:
+        Pipeline(size_t queue_size=4);
+        ~Pipeline();
+        template <class S> int source(S &source) {
+            if (running) {
+                return 0;
+            }
+            src.reset(new PipelineSourceAdapter<S>(source));
+            return (src != nullptr);
+        }
+        int stage(PipelineStage &stage) {
+            return add(&stage, false);
+        }
+        template <class S> int sink(S &sink) {
+            return add(new PipelineSink<S>(sink), true);
+        }
+        int begin(uint32_t mode=AN_PIPELINE_INLINE, size_t stack_size=4096);
+        size_t poll();
+        int stop();
+        size_t stages() {
+            return n_stages;
+        }
+        PipelineStats stats(size_t stage);
+};
+
+struct scheduler_worker_t;
+
+struct sched_slot_t {
+    DMABuffer<Sample> *buf;
+    std::atomic<bool> done;
+};
+
+// Runs a stage on a pool of worker threads. Each worker has its own queue of
+// buffers, and idle workers steal buffers from the others, so the stage's
+// process() must be safe to call from several threads. Buffer pools have a
+// single producer, so the stage must process buffers in place and return them,
+// they are released by the caller of next(). Buffers submitted with
+// the same key (e.g. a channel) always run on the same worker, one at a time
+// and in submission order. Processed buffers are reordered, and returned by
+// next() in submission order.
+class BlockScheduler {
+    private:
+        PipelineStage &stage;
+        size_t n_workers;
+        size_t capacity;
+        std::unique_ptr<sched_slot_t[]> slots;
+        std::atomic<uint32_t> seq_in;
+        std::atomic<uint32_t> seq_out;
+        size_t next_worker;
+        scheduler_worker_t *workers[AN_MAX_SCHED_WORKERS];
+        std::atomic<bool> running;
+        std::atomic<uint32_t> n_stolen;
+
+        static void run(pipeline_thread_t *thread);
+
+    public:
+        BlockScheduler(PipelineStage &stage, size_t n_workers, size_t capacity=16);
+        ~BlockScheduler();
+        int begin(size_t stack_size=4096);
+        bool submit(DMABuffer<Sample> *buf, uint32_t key=AN_SCHED_ANY);
+        DMABuffer<Sample> *next();
+        size_t pending();
+        uint32_t processed(size_t worker);
+        uint32_t stolen() {
+            return n_stolen;
+        }
+        int stop();
+};
+
+#endif  // __PIPELINE_H__
@@ -20,13 +20,18 @@
 #ifndef __QUEUE_H__
 #define __QUEUE_H__
 
+#include <atomic>
 #include "Arduino.h"
 
+// Single producer, single consumer queue. The producer and consumer can be an
+// ISR and a thread, or two threads: head is only written by the producer and
+// tail by the consumer, with release/acquire ordering so the element written
+// is visible before the index that publishes it.
 template <class T> class Queue {
     private:
         size_t capacity;
-        volatile size_t tail;
-        volatile size_t head;
+        std::atomic<size_t> tail;
+        std::atomic<size_t> head;
         std::unique_ptr<T[]> buff;
 
     private:
@@ -38,7 +43,6 @@ template <class T> class Queue {
         Queue(size_t size=0):
          capacity(size), tail(0), head(0), buff(nullptr) {
             if (size) {
-                tail = head = 0;
                 capacity = size + 1;
                 buff.reset(new T[capacity]);
             }
@@ -52,26 +56,66 @@ template <class T> class Queue {
             return tail == head;
         }
 
+        size_t size() {
+            if (capacity == 0) {
+                return 0;
+            }
+            return (head.load(std::memory_order_acquire) + capacity - tail.load(std::memory_order_acquire)) % capacity;
+        }
+
+        bool resize(size_t size) {
+            // Reallocate the queue keeping its elements. The new storage is allocated
+            // first, and the elements moved with interrupts disabled, so this is safe
+            // to call while the other end of the queue is used from an ISR. Without
+            // interrupts (host builds), the other end must not be used meanwhile.
+            std::unique_ptr<T[]> newbuff(new T[size + 1]);
+            if (!newbuff) {
+                return false;
+            }
+
+            #if defined(ARDUINO_ARCH_MBED)
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            #endif
+            size_t count = 0;
+            bool ret = (this->size() <= size);
+            if (ret) {
+                for (size_t i=tail; i!=head; i=next_pos(i)) {
+                    newbuff[count++] = buff[i];
+                }
+                buff.swap(newbuff);
+                capacity = size + 1;
+                tail = 0;
+                head = count;
+            }
+            #if defined(ARDUINO_ARCH_MBED)
+            __set_PRIMASK(primask);
+            #endif
+            return ret;
+        }
+
         operator bool() const {
             return buff.get() != nullptr;
         }
 
         bool push(T data) {
             bool ret = false;
-            size_t next = next_pos(head);
-            if (buff && (next != tail)) {
-                buff[head] = data;
-                head = next;
+            size_t pos = head.load(std::memory_order_relaxed);
+            size_t next = next_pos(pos);
+            if (buff && (next != tail.load(std::memory_order_acquire))) {
+                buff[pos] = data;
+                head.store(next, std::memory_order_release);
                 ret = true;
             }
             return ret;
         }
 
         T pop(bool peek=false) {
-            if (buff && (tail != head)) {
-                T data = buff[tail];
+            size_t pos = tail.load(std::memory_order_relaxed);
+            if (buff && (pos != head.load(std::memory_order_acquire))) {
+                T data = buff[pos];
                 if (!peek) {
-                    tail = next_pos(tail);
+                    tail.store(next_pos(pos), std::memory_order_release);
                 }
                 return data;
             }
@@ -0,0 +1,331 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ResponseAnalyzer.h"
+
+// The DAC always runs at 12 bits.
+#define DAC_FULL_SCALE      (4095)
+static uint32_t ADC_BITS_LUT[] = {8, 10, 12, 14, 16};
+
+static float wrap_degrees(float phase) {
+    phase = fmodf(phase, 360.0f);
+    if (phase > 180.0f) {
+        phase -= 360.0f;
+    } else if (phase <= -180.0f) {
+        phase += 360.0f;
+    }
+    return phase;
+}
+
+ResponseAnalyzer::~ResponseAnalyzer() {
+    stop();
+}
+
+int ResponseAnalyzer::begin(AdvancedADC &adc, AdvancedDAC &dac, uint32_t resolution,
+        uint32_t sample_rate, size_t n_samples, size_t n_buffers) {
+    // The DAC starts after 3 buffers are written, so at least 3 are needed. Only
+    // DAC channel 1 can trigger the ADC (see AN_TRIGGER_DAC).
+    if (resolution >= AN_ARRAY_SIZE(ADC_BITS_LUT) || sample_rate == 0 || n_samples == 0 || n_buffers < 3
+     || dac.channel() != 1) {
+        return 0;
+    }
+
+    stop();
+    // Records of the blocks written to the DAC and not yet captured. The DAC
+    // can't be more than its own pool and the ADC's pool ahead of the ADC.
+    n_ring = 2 * n_buffers + 2;
+    ring.reset(new sweep_block_t[n_ring]);
+    if (!ring) {
+        return 0;
+    }
+    this->adc = &adc;
+    this->dac = &dac;
+    this->resolution = resolution;
+    this->sample_rate = sample_rate;
+    this->n_samples = n_samples;
+    this->n_buffers = n_buffers;
+    return 1;
+}
+
+int ResponseAnalyzer::amplitude(float level) {
+    // Stimulus amplitude, as a fraction of the DAC's half scale.
+    if (level <= 0.0f || level > 1.0f) {
+        return 0;
+    }
+    this->level = level;
+    return 1;
+}
+
+int ResponseAnalyzer::sweep(float f_start, float f_stop, size_t n_points, uint32_t mode, size_t n_settle, size_t n_measure) {
+    if (adc == nullptr || running || n_points == 0 || n_measure == 0 || mode > AN_SWEEP_CHIRP
+     || f_start <= 0.0f || f_stop <= 0.0f || f_start >= (sample_rate / 2) || f_stop >= (sample_rate / 2)) {
+        return 0;
+    }
+
+    freqs.reset(new float[n_points]);
+    results.reset(new float[n_points * AN_MAX_ADC_CHANNELS * 2]);
+    if (!freqs || !results) {
+        return 0;
+    }
+
+    // Configure the DAC first, then arm the ADC on the DAC's timer. Both start
+    // with the timer once the first DAC buffers are written.
+    if (!dac->begin(AN_RESOLUTION_12, sample_rate, n_samples, n_buffers)) {
+        return 0;
+    }
+    if (!adc->trigger(AN_TRIGGER_DAC) || !adc->begin(resolution, sample_rate, n_samples, n_buffers)) {
+        adc->trigger(AN_TRIGGER_TIMER);
+        dac->stop();
+        return 0;
+    }
+
+    dds.begin(dac->rate());
+    for (size_t c=0; c<AN_MAX_ADC_CHANNELS; c++) {
+        skews[c] = adc->skew(c);
+    }
+    this->f_start = f_start;
+    this->f_stop = f_stop;
+    this->n_points = n_points;
+    this->mode = mode;
+    this->n_settle = n_settle;
+    this->n_measure = (mode == AN_SWEEP_CHIRP) ? 1 : n_measure;
+    n_done = 0;
+    dac_blocks = 0;
+    adc_blocks = 0;
+    fit = {};
+    running = true;
+    poll();
+    return 1;
+}
+
+bool ResponseAnalyzer::schedule(uint32_t block, sweep_block_t *blk) {
+    // In stepped mode, each point has n_settle blocks for the response to settle,
+    // then n_measure blocks measured. In chirp mode, the first point settles for
+    // n_settle blocks, then each block is a point.
+    size_t point, index;
+    if (mode == AN_SWEEP_CHIRP) {
+        point = (block < n_settle) ? 0 : block - n_settle;
+        index = (block < n_settle) ? 0 : n_settle;
+    } else {
+        point = block / (n_settle + n_measure);
+        index = block % (n_settle + n_measure);
+    }
+
+    blk->point = -1;
+    blk->last = false;
+    if (point < n_points) {
+        // Logarithmic frequency steps.
+        float f = f_start;
+        if (n_points > 1) {
+            f = f_start * powf(f_stop / f_start, (float) point / (n_points - 1));
+        }
+        dds.frequency(f);
+        freqs[point] = dds.frequency();
+        if (index >= n_settle) {
+            blk->point = point;
+            blk->last = (index == n_settle + n_measure - 1) || (mode == AN_SWEEP_CHIRP);
+        }
+    }
+    blk->phase = dds.phase();
+    blk->step = dds.step();
+    return point < n_points;
+}
+
+void ResponseAnalyzer::measure(SampleBuffer buf, sweep_block_t *blk) {
+    size_t n_channels = buf.channels();
+    size_t n_frames = buf.size() / (n_channels ? n_channels : 1);
+    if (blk->point < 0 || n_channels == 0 || n_channels > AN_MAX_ADC_CHANNELS) {
+        return;
+    }
+
+    const Sample *data = buf.data();
+    if (fit.n == 0) {
+        // Remove a constant offset to keep the sums small.
+        for (size_t c=0; c<n_channels; c++) {
+            fit.offset[c] = data[c];
+        }
+    }
+
+    // Correlate each channel with the stimulus. Partial sums are kept in
+    // single precision for each block.
+    float s = 0, co = 0, ss = 0, cc = 0, sc = 0;
+    float x[AN_MAX_ADC_CHANNELS] = {0}, xs[AN_MAX_ADC_CHANNELS] = {0}, xc[AN_MAX_ADC_CHANNELS] = {0};
+    uint32_t phase = blk->phase;
+    for (size_t i=0; i<n_frames; i++, phase+=blk->step) {
+        float si = DDS::sine(phase) * (1.0f / 32767);
+        float ci = DDS::cosine(phase) * (1.0f / 32767);
+        s += si;
+        co += ci;
+        ss += si * si;
+        cc += ci * ci;
+        sc += si * ci;
+        for (size_t c=0; c<n_channels; c++) {
+            float xi = data[i * n_channels + c] - fit.offset[c];
+            x[c] += xi;
+            xs[c] += xi * si;
+            xc[c] += xi * ci;
+        }
+    }
+    fit.s += s;
+    fit.c += co;
+    fit.ss += ss;
+    fit.cc += cc;
+    fit.sc += sc;
+    for (size_t c=0; c<n_channels; c++) {
+        fit.x[c] += x[c];
+        fit.xs[c] += xs[c];
+        fit.xc[c] += xc[c];
+    }
+    fit.n += n_frames;
+
+    if (blk->last) {
+        // Solve the normal equations with Cramer's rule:
+        // | ss sc s | | a |   | xs |
+        // | sc cc c | | b | = | xc |
+        // | s  c  n | | d |   | x  |
+        // For x = A * sin(wt + theta): a = A * cos(theta), b = A * sin(theta).
+        size_t point = blk->point;
+        double n = fit.n;
+        double det = fit.ss * (fit.cc * n - fit.c * fit.c) - fit.sc * (fit.sc * n - fit.c * fit.s)
+                   + fit.s * (fit.sc * fit.c - fit.cc * fit.s);
+        float dac_level = (float) stimulus() / DAC_FULL_SCALE;
+        float full_scale = (1 << ADC_BITS_LUT[resolution]) - 1;
+        for (size_t c=0; c<n_channels; c++) {
+            double a = 0, b = 0;
+            if (det != 0.0) {
+                a = (fit.xs[c] * (fit.cc * n - fit.c * fit.c) - fit.sc * (fit.xc[c] * n - fit.c * fit.x[c])
+                    + fit.s * (fit.xc[c] * fit.c - fit.cc * fit.x[c])) / det;
+                b = (fit.ss * (fit.xc[c] * n - fit.c * fit.x[c]) - fit.xs[c] * (fit.sc * n - fit.c * fit.s)
+                    + fit.s * (fit.sc * fit.x[c] - fit.xc[c] * fit.s)) / det;
+            }
+            float amp = sqrt(a * a + b * b);
+            float theta = atan2(b, a) * 180.0 / PI;
+            // Channel c is sampled skews[c] after the stimulus update.
+            theta -= 360.0f * freqs[point] * skews[c];
+            result(point, c)[0] = (amp / full_scale) / dac_level;
+            result(point, c)[1] = wrap_degrees(theta);
+        }
+        fit = {};
+        n_done = point + 1;
+    }
+}
+
+int ResponseAnalyzer::poll() {
+    // Keeps the DAC fed and processes the captured buffers. Returns 1 when the
+    // sweep is complete, or was aborted because samples were dropped, in which
+    // case points() is less than the number of points requested.
+    if (!running) {
+        return 1;
+    }
+
+    while (dac->available()) {
+        SampleBuffer buf = dac->dequeue();
+        sweep_block_t *blk = &ring[dac_blocks % n_ring];
+        // Silence after the last point, until the capture is complete.
+        bool active = schedule(dac_blocks++, blk);
+        dds.generate(buf, active ? stimulus() : 0, (DAC_FULL_SCALE + 1) / 2);
+        dac->write(buf);
+    }
+
+    while (adc->available()) {
+        SampleBuffer buf = adc->read();
+        bool discont = buf.getflags(DMA_BUFFER_DISCONT);
+        if (!discont) {
+            measure(buf, &ring[adc_blocks++ % n_ring]);
+        }
+        buf.release();
+        if (discont || n_done == n_points) {
+            stop();
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t ResponseAnalyzer::stimulus() {
+    // Stimulus amplitude in DAC codes.
+    return level * (DAC_FULL_SCALE / 2);
+}
+
+float ResponseAnalyzer::frequency(size_t point) {
+    // Returns the exact frequency of a point, after rounding by the DDS.
+    if (point >= n_done) {
+        return 0.0f;
+    }
+    return freqs[point];
+}
+
+float ResponseAnalyzer::gain(size_t point, size_t channel) {
+    // Returns the gain of a point in V/V, relative to the reference if set.
+    if (point >= n_done || channel >= AN_MAX_ADC_CHANNELS) {
+        return 0.0f;
+    }
+    float g = result(point, channel)[0];
+    if (reference && ref_points == n_points && ref_start == f_start && ref_stop == f_stop) {
+        float ref = result(point, channel, true)[0];
+        g = (ref > 0.0f) ? g / ref : 0.0f;
+    }
+    return g;
+}
+
+float ResponseAnalyzer::phase(size_t point, size_t channel) {
+    // Returns the phase of a point in degrees, relative to the reference if set.
+    if (point >= n_done || channel >= AN_MAX_ADC_CHANNELS) {
+        return 0.0f;
+    }
+    float p = result(point, channel)[1];
+    if (reference && ref_points == n_points && ref_start == f_start && ref_stop == f_stop) {
+        p = wrap_degrees(p - result(point, channel, true)[1]);
+    }
+    return p;
+}
+
+int ResponseAnalyzer::calibrate(bool enable) {
+    // Stores the last sweep as the reference, which applies to later sweeps
+    // with the same frequencies, or clears the reference.
+    if (!enable) {
+        reference.reset();
+        ref_points = 0;
+        return 1;
+    }
+
+    if (n_points == 0 || n_done != n_points) {
+        return 0;
+    }
+    reference.reset(new float[n_points * AN_MAX_ADC_CHANNELS * 2]);
+    if (!reference) {
+        return 0;
+    }
+    memcpy(reference.get(), results.get(), n_points * AN_MAX_ADC_CHANNELS * 2 * sizeof(float));
+    ref_points = n_points;
+    ref_start = f_start;
+    ref_stop = f_stop;
+    return 1;
+}
+
+int ResponseAnalyzer::stop() {
+    if (running) {
+        adc->stop();
+        adc->trigger(AN_TRIGGER_TIMER);
+        dac->stop();
+        running = false;
+    }
+    return 1;
+}
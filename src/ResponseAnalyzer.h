@@ -0,0 +1,118 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __RESPONSE_ANALYZER_H__
+#define __RESPONSE_ANALYZER_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "AdvancedADC.h"
+#include "AdvancedDAC.h"
+#include "DDS.h"
+
+enum {
+    AN_SWEEP_STEPPED = 0U,  // Each frequency is held for a few buffers.
+    AN_SWEEP_CHIRP   = 1U,  // The frequency changes every buffer, with continuous phase.
+};
+
+struct sweep_block_t {
+    uint32_t phase;     // DDS phase of the block's first sample.
+    uint32_t step;      // DDS phase step.
+    int32_t point;      // Point measured by this block, -1 if none.
+    bool last;          // Last block of the point.
+};
+
+struct sweep_fit_t {
+    // Sums for the least squares fit of x = a * sin + b * cos + d, which doesn't
+    // need a whole number of periods.
+    double s, c, ss, cc, sc;
+    double x[AN_MAX_ADC_CHANNELS];
+    double xs[AN_MAX_ADC_CHANNELS];
+    double xc[AN_MAX_ADC_CHANNELS];
+    float offset[AN_MAX_ADC_CHANNELS];
+    uint32_t n;
+};
+
+// Frequency response analyzer: drives a sine sweep on a DAC channel and
+// captures the response on all channels of an ADC, which is triggered by the
+// DAC's timer so each ADC sample is taken with the DAC sample of the same
+// index. Gain and phase are computed per frequency point by correlating the
+// response with the stimulus, regenerated from the DDS phase recorded for each
+// buffer. A sweep of a direct DAC to ADC connection can be stored as a
+// reference to remove the converters' own response.
+class ResponseAnalyzer {
+    private:
+        AdvancedADC *adc;
+        AdvancedDAC *dac;
+        DDS dds;
+        uint32_t resolution;
+        uint32_t sample_rate;
+        size_t n_samples;
+        size_t n_buffers;
+        float level;
+        float skews[AN_MAX_ADC_CHANNELS];   // Sample time of each channel after the first.
+        uint32_t mode;
+        float f_start;
+        float f_stop;
+        size_t n_points;
+        size_t n_done;
+        size_t n_settle;
+        size_t n_measure;
+        uint32_t dac_blocks;
+        uint32_t adc_blocks;
+        size_t n_ring;
+        bool running;
+        std::unique_ptr<sweep_block_t[]> ring;
+        std::unique_ptr<float[]> freqs;
+        std::unique_ptr<float[]> results;       // Gain and phase per point and channel.
+        std::unique_ptr<float[]> reference;
+        size_t ref_points;
+        float ref_start;
+        float ref_stop;
+        sweep_fit_t fit;
+
+        bool schedule(uint32_t block, sweep_block_t *blk);
+        uint32_t stimulus();
+        void measure(SampleBuffer buf, sweep_block_t *blk);
+        float *result(size_t point, size_t channel, bool ref=false) {
+            return &(ref ? reference : results)[(point * AN_MAX_ADC_CHANNELS + channel) * 2];
+        }
+
+    public:
+        ResponseAnalyzer(): adc(nullptr), dac(nullptr), resolution(0), sample_rate(0), n_samples(0), n_buffers(0),
+            level(0.5f), skews(), mode(AN_SWEEP_STEPPED), f_start(0), f_stop(0), n_points(0), n_done(0),
+            n_settle(0), n_measure(0), dac_blocks(0), adc_blocks(0), n_ring(0), running(false),
+            ref_points(0), ref_start(0), ref_stop(0), fit() {
+        }
+        ~ResponseAnalyzer();
+        int begin(AdvancedADC &adc, AdvancedDAC &dac, uint32_t resolution, uint32_t sample_rate, size_t n_samples, size_t n_buffers);
+        int amplitude(float level);
+        int sweep(float f_start, float f_stop, size_t n_points, uint32_t mode=AN_SWEEP_STEPPED, size_t n_settle=2, size_t n_measure=4);
+        int poll();
+        size_t points() {
+            return n_done;
+        }
+        float frequency(size_t point);
+        float gain(size_t point, size_t channel=0);
+        float phase(size_t point, size_t channel=0);
+        int calibrate(bool enable=true);
+        int stop();
+};
+
+#endif  // __RESPONSE_ANALYZER_H__
@@ -0,0 +1,237 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "RiceCodec.h"
+
+class BitWriter {
+    private:
+        uint8_t *dst;
+        size_t size;
+        uint64_t acc;
+        uint32_t bits;
+
+    public:
+        size_t pos;
+        bool overflow;
+
+        BitWriter(uint8_t *dst, size_t size):
+            dst(dst), size(size), acc(0), bits(0), pos(0), overflow(false) {
+        }
+
+        inline void put(uint32_t v, uint32_t n) {
+            // NOTE: n must be <= 32.
+            acc = (acc << n) | (n < 32 ? (v & ((1UL << n) - 1)) : v);
+            bits += n;
+            while (bits >= 8) {
+                bits -= 8;
+                if (pos < size) {
+                    dst[pos++] = acc >> bits;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+
+        inline void unary(uint32_t q) {
+            // q zeros, terminated by a one.
+            for (; q >= 31; q -= 31) {
+                put(0, 31);
+            }
+            put(1, q + 1);
+        }
+
+        void flush() {
+            if (bits) {
+                put(0, 8 - bits);
+            }
+        }
+};
+
+class BitReader {
+    private:
+        const uint8_t *src;
+        size_t size;
+        size_t pos;
+        uint64_t acc;
+        uint32_t bits;
+
+    public:
+        bool error;
+
+        BitReader(const uint8_t *src, size_t size):
+            src(src), size(size), pos(0), acc(0), bits(0), error(false) {
+        }
+
+        inline uint32_t get(uint32_t n) {
+            while (bits < n) {
+                if (pos == size) {
+                    error = true;
+                    return 0;
+                }
+                acc = (acc << 8) | src[pos++];
+                bits += 8;
+            }
+            bits -= n;
+            return (acc >> bits) & ((1ULL << n) - 1);
+        }
+
+        inline uint32_t unary(uint32_t max) {
+            uint32_t q = 0;
+            while (get(1) == 0 && !error) {
+                if (++q > max) {
+                    error = true;
+                    break;
+                }
+            }
+            return q;
+        }
+};
+
+static inline uint16_t zigzag(uint16_t x, uint16_t prev) {
+    int16_t d = (int16_t) (uint16_t) (x - prev);
+    return (uint16_t) ((d << 1) ^ (d >> 15));
+}
+
+static inline uint16_t unzigzag(uint16_t u, uint16_t prev) {
+    return prev + (uint16_t) ((u >> 1) ^ (-(u & 1)));
+}
+
+size_t RiceCodec::max_size(size_t n_samples, size_t n_channels) {
+    // Worst case: every partition is stored verbatim.
+    size_t n_parts = (n_samples + AN_RICE_PARTITION - 1) / AN_RICE_PARTITION;
+    size_t bits = n_channels * (16 * n_samples + 4 * n_parts);
+    return AN_RICE_HEADER_SIZE + (bits + 7) / 8;
+}
+
+size_t RiceCodec::encode(const Sample *src, size_t n_samples, size_t n_channels, uint8_t *dst, size_t size) {
+    if (n_channels == 0 || n_channels > 255 || n_samples == 0 || size < AN_RICE_HEADER_SIZE) {
+        return 0;
+    }
+
+    dst[0] = n_channels;
+    dst[1] = AN_RICE_PARTITION_LOG2;
+    dst[2] = n_samples; dst[3] = n_samples >> 8; dst[4] = n_samples >> 16; dst[5] = n_samples >> 24;
+
+    BitWriter bw(dst + AN_RICE_HEADER_SIZE, size - AN_RICE_HEADER_SIZE);
+    uint16_t res[AN_RICE_PARTITION];
+
+    for (size_t c=0; c<n_channels; c++) {
+        const Sample *x = src + c;
+        uint16_t prev = x[0];
+        bw.put(prev, 16);
+
+        for (size_t start=1; start<n_samples; start+=AN_RICE_PARTITION) {
+            size_t count = n_samples - start;
+            if (count > AN_RICE_PARTITION) {
+                count = AN_RICE_PARTITION;
+            }
+
+            // Delta prediction, zigzag mapped to unsigned residuals.
+            uint32_t sum = 0;
+            const Sample *p = x + start * n_channels;
+            for (size_t i=0; i<count; i++, p+=n_channels) {
+                res[i] = zigzag(*p, prev);
+                prev = *p;
+                sum += res[i];
+            }
+
+            // Estimate the Rice parameter from the mean, and pick the
+            // cheapest of its neighbours.
+            uint32_t mean = sum / count;
+            int k0 = mean ? (31 - __builtin_clz(mean)) : 0;
+            k0 = (k0 > 0) ? k0 - 1 : 0;
+            uint32_t cost[3] = {0, 0, 0};
+            for (size_t i=0; i<count; i++) {
+                cost[0] += res[i] >> k0;
+                cost[1] += res[i] >> (k0 + 1);
+                cost[2] += res[i] >> (k0 + 2);
+            }
+            int k = AN_RICE_ESCAPE;
+            uint32_t best = 16 * count;
+            for (int j=0; j<3; j++) {
+                uint32_t bits = cost[j] + count * (k0 + j + 1);
+                if ((k0 + j) < AN_RICE_ESCAPE && bits < best) {
+                    best = bits;
+                    k = k0 + j;
+                }
+            }
+
+            bw.put(k, 4);
+            if (k == AN_RICE_ESCAPE) {
+                for (size_t i=0; i<count; i++) {
+                    bw.put(res[i], 16);
+                }
+            } else {
+                for (size_t i=0; i<count; i++) {
+                    bw.unary(res[i] >> k);
+                    bw.put(res[i], k);
+                }
+            }
+        }
+    }
+    bw.flush();
+    return bw.overflow ? 0 : (AN_RICE_HEADER_SIZE + bw.pos);
+}
+
+size_t RiceCodec::decode(const uint8_t *src, size_t size, Sample *dst, size_t n, size_t *n_channels) {
+    if (size < AN_RICE_HEADER_SIZE) {
+        return 0;
+    }
+
+    size_t channels = src[0];
+    size_t part_size = 1UL << src[1];
+    size_t n_samples = src[2] | (src[3] << 8) | (src[4] << 16) | ((uint32_t) src[5] << 24);
+    if (channels == 0 || src[1] > 16 || n_samples == 0 || (n_samples * channels) > n) {
+        return 0;
+    }
+
+    BitReader br(src + AN_RICE_HEADER_SIZE, size - AN_RICE_HEADER_SIZE);
+    for (size_t c=0; c<channels; c++) {
+        Sample *x = dst + c;
+        uint16_t prev = x[0] = br.get(16);
+
+        for (size_t start=1; start<n_samples; start+=part_size) {
+            size_t count = n_samples - start;
+            if (count > part_size) {
+                count = part_size;
+            }
+
+            uint32_t k = br.get(4);
+            Sample *p = x + start * channels;
+            for (size_t i=0; i<count; i++, p+=channels) {
+                uint32_t u;
+                if (k == AN_RICE_ESCAPE) {
+                    u = br.get(16);
+                } else {
+                    uint32_t q = br.unary(0xFFFFUL >> k);
+                    u = (q << k) | br.get(k);
+                }
+                prev = *p = unzigzag(u, prev);
+            }
+            if (br.error) {
+                return 0;
+            }
+        }
+    }
+
+    if (n_channels) {
+        *n_channels = channels;
+    }
+    return n_samples;
+}
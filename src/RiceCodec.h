@@ -0,0 +1,54 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __RICE_CODEC_H__
+#define __RICE_CODEC_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+// Lossless block codec for interleaved sample buffers. Each channel is
+// delta-predicted, the residuals are zigzag mapped and Rice coded in
+// partitions of AN_RICE_PARTITION samples, each with its own parameter.
+// Partitions that don't compress are stored verbatim, which bounds the
+// worst-case expansion to 4 bits per partition plus the block header.
+//
+// Block layout: channels (1 byte), log2 of the partition size (1 byte),
+// samples per channel (4 bytes, little-endian), followed by an MSB-first
+// bitstream with, for each channel, the first sample (16 bits) and the
+// partitions (4 bits parameter + codes, parameter 15 = verbatim).
+#define AN_RICE_HEADER_SIZE     (6)
+#define AN_RICE_PARTITION_LOG2  (6)
+#define AN_RICE_PARTITION       (1 << AN_RICE_PARTITION_LOG2)
+#define AN_RICE_ESCAPE          (15)
+
+class RiceCodec {
+    public:
+        static size_t max_size(size_t n_samples, size_t n_channels);
+        static size_t encode(const Sample *src, size_t n_samples, size_t n_channels, uint8_t *dst, size_t size);
+        static size_t encode(SampleBuffer buf, uint8_t *dst, size_t size) {
+            if (buf.channels() == 0) {
+                return 0;
+            }
+            return encode(buf.data(), buf.size() / buf.channels(), buf.channels(), dst, size);
+        }
+        static size_t decode(const uint8_t *src, size_t size, Sample *dst, size_t n, size_t *n_channels=nullptr);
+};
+
+#endif  // __RICE_CODEC_H__
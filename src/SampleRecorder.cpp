@@ -0,0 +1,275 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SampleRecorder.h"
+
+static const uint8_t ADC_BITS_LUT[] = {
+    8, 10, 12, 14, 16,
+};
+
+static inline void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v; p[1] = v >> 8;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+SampleRecorder::SampleRecorder(size_t block_size, size_t index_interval):
+    file(nullptr), format(AN_RECORDER_WAV), block_size(block_size), index_interval(index_interval), index_size(0),
+    n_channels(0), resolution(0), sample_rate(0), block(nullptr, AlignedAlloc<__SCB_DCACHE_LINE_SIZE>::free),
+    index(nullptr), n_index(0), offset(0), capacity(0), n_bytes(0), frames(0), block_frame(0), block_ts(0), block_flags(0),
+    file_offset(0) {
+    // Blocks are whole sectors.
+    this->block_size = ((block_size + AN_RECORDER_SECTOR - 1) / AN_RECORDER_SECTOR) * AN_RECORDER_SECTOR;
+    if (this->block_size < AN_RECORDER_SECTOR * 2) {
+        this->block_size = AN_RECORDER_SECTOR * 2;
+    }
+    if (this->index_interval == 0) {
+        this->index_interval = 1;
+    }
+}
+
+SampleRecorder::~SampleRecorder() {
+    end();
+}
+
+size_t SampleRecorder::write_block(size_t size) {
+    uint32_t start = micros();
+    size_t ret = fwrite(block.get(), 1, size, file);
+    uint32_t elapsed = micros() - start;
+
+    if (rstats.writes == 0 || elapsed < rstats.min_us) {
+        rstats.min_us = elapsed;
+    }
+    if (elapsed > rstats.max_us) {
+        rstats.max_us = elapsed;
+    }
+    rstats.writes++;
+    rstats.total_us += elapsed;
+    rstats.bytes += ret;
+    if (ret != size) {
+        rstats.errors++;
+    }
+    file_offset += ret;
+    return ret;
+}
+
+void SampleRecorder::write_header() {
+    uint8_t *p = block.get();
+    memset(p, 0, AN_RECORDER_SECTOR);
+
+    if (format == AN_RECORDER_WAV) {
+        uint32_t data_size = frames * n_channels * sizeof(int16_t);
+        memcpy(&p[0], "RIFF", 4);
+        put_le32(&p[4], AN_RECORDER_SECTOR - 8 + data_size);
+        memcpy(&p[8], "WAVE", 4);
+        memcpy(&p[12], "fmt ", 4);
+        put_le32(&p[16], 16);
+        put_le16(&p[20], 1);    // PCM
+        put_le16(&p[22], n_channels);
+        put_le32(&p[24], sample_rate);
+        put_le32(&p[28], sample_rate * n_channels * sizeof(int16_t));
+        put_le16(&p[32], n_channels * sizeof(int16_t));
+        put_le16(&p[34], 16);
+        // Pad the header with a JUNK chunk, so samples start at a sector boundary.
+        memcpy(&p[36], "JUNK", 4);
+        put_le32(&p[40], AN_RECORDER_SECTOR - 52);
+        memcpy(&p[AN_RECORDER_SECTOR - 8], "data", 4);
+        put_le32(&p[AN_RECORDER_SECTOR - 4], data_size);
+    } else {
+        memcpy(&p[0], "AARC", 4);
+        put_le32(&p[4], AN_RECORDER_VERSION);
+        put_le32(&p[8], sample_rate);
+        put_le32(&p[12], n_channels);
+        put_le32(&p[16], resolution);
+        put_le32(&p[20], block_size);
+        put_le32(&p[24], index_interval);
+        put_le32(&p[28], index_size);
+        put_le32(&p[32], frames);
+        put_le32(&p[36], frames >> 32);
+    }
+    write_block(AN_RECORDER_SECTOR);
+}
+
+void SampleRecorder::write_index() {
+    if (n_index == 0) {
+        return;
+    }
+
+    uint8_t *p = block.get();
+    memset(p, 0, index_size);
+    memcpy(&p[0], "INDX", 4);
+    put_le32(&p[4], index_size - 8);
+    put_le32(&p[8], n_index);
+    for (size_t i=0; i<n_index * 4; i++) {
+        put_le32(&p[AN_RECORDER_INDEX_HEADER + i * 4], index[i]);
+    }
+    write_block(index_size);
+    n_index = 0;
+}
+
+void SampleRecorder::commit() {
+    if (format == AN_RECORDER_WAV) {
+        write_block(offset);
+    } else {
+        uint8_t *p = block.get();
+        uint32_t chunk_offset = file_offset;
+        memcpy(&p[0], "DATA", 4);
+        put_le32(&p[4], block_size - 8);
+        put_le32(&p[8], block_frame);
+        put_le32(&p[12], block_frame >> 32);
+        put_le32(&p[16], block_ts);
+        put_le32(&p[20], block_flags);
+        put_le32(&p[24], offset - AN_RECORDER_DATA_HEADER);
+        memset(&p[offset], 0, block_size - offset);
+        write_block(block_size);
+
+        uint32_t *entry = &index[n_index++ * 4];
+        entry[0] = block_frame;
+        entry[1] = block_frame >> 32;
+        entry[2] = block_ts;
+        entry[3] = chunk_offset;
+        if (n_index == index_interval) {
+            write_index();
+        }
+    }
+    offset = (format == AN_RECORDER_WAV) ? 0 : AN_RECORDER_DATA_HEADER;
+    block_frame = frames;
+    block_flags = 0;
+}
+
+int SampleRecorder::begin(FILE *file, uint32_t format, uint32_t sample_rate, size_t n_channels, uint32_t resolution) {
+    // Sanity checks.
+    if (file == nullptr || this->file != nullptr || n_channels == 0 || format > AN_RECORDER_CHUNKED
+            || resolution >= AN_ARRAY_SIZE(ADC_BITS_LUT)) {
+        return 0;
+    }
+
+    block.reset((uint8_t *) AlignedAlloc<__SCB_DCACHE_LINE_SIZE>::malloc(block_size));
+    if (!block) {
+        return 0;
+    }
+
+    if (format == AN_RECORDER_CHUNKED) {
+        index_size = AN_RECORDER_INDEX_HEADER + index_interval * AN_RECORDER_INDEX_ENTRY;
+        index_size = ((index_size + AN_RECORDER_SECTOR - 1) / AN_RECORDER_SECTOR) * AN_RECORDER_SECTOR;
+        index.reset(new uint32_t[index_interval * 4]);
+        if (!index || index_size > block_size) {
+            block.reset();
+            return 0;
+        }
+    }
+
+    this->file = file;
+    this->format = format;
+    this->sample_rate = sample_rate;
+    this->n_channels = n_channels;
+    this->resolution = resolution;
+    memset(&rstats, 0, sizeof(rstats));
+    frames = block_frame = n_bytes = 0;
+    block_flags = block_ts = 0;
+    n_index = 0;
+    file_offset = 0;
+
+    // WAV streams are contiguous, chunks hold whole frames.
+    size_t frame_bytes = n_channels * sizeof(Sample);
+    if (format == AN_RECORDER_WAV) {
+        offset = 0;
+        capacity = block_size;
+    } else {
+        offset = AN_RECORDER_DATA_HEADER;
+        capacity = ((block_size - AN_RECORDER_DATA_HEADER) / frame_bytes) * frame_bytes + AN_RECORDER_DATA_HEADER;
+    }
+
+    write_header();
+    return (rstats.errors == 0);
+}
+
+size_t SampleRecorder::write(SampleBuffer buf) {
+    if (file == nullptr || buf.channels() != n_channels) {
+        return 0;
+    }
+
+    if (offset == ((format == AN_RECORDER_WAV) ? 0 : AN_RECORDER_DATA_HEADER)) {
+        block_ts = buf.timestamp();
+    }
+    if (buf.getflags(DMA_BUFFER_DISCONT)) {
+        block_flags |= DMA_BUFFER_DISCONT;
+    }
+
+    // WAV samples are signed, left-aligned to 16 bits.
+    uint32_t shift = 16 - ADC_BITS_LUT[resolution];
+    const uint8_t *src = (const uint8_t *) buf.data();
+    size_t size = buf.bytes();
+
+    while (size) {
+        size_t n = capacity - offset;
+        if (n > size) {
+            n = size;
+        }
+        if (format == AN_RECORDER_WAV) {
+            const Sample *s = (const Sample *) src;
+            Sample *d = (Sample *) &block.get()[offset];
+            for (size_t i=0; i<n/sizeof(Sample); i++) {
+                d[i] = (s[i] << shift) ^ 0x8000;
+            }
+        } else {
+            memcpy(&block.get()[offset], src, n);
+        }
+        offset += n;
+        src += n;
+        size -= n;
+        n_bytes += n;
+        frames = n_bytes / (n_channels * sizeof(Sample));
+
+        if (offset == capacity) {
+            commit();
+            if (size) {
+                block_ts = buf.timestamp();
+            }
+        }
+    }
+    return buf.bytes();
+}
+
+int SampleRecorder::end() {
+    if (file == nullptr) {
+        return 0;
+    }
+
+    // Write out the last partial block, and the pending index entries.
+    if (offset > ((format == AN_RECORDER_WAV) ? 0 : AN_RECORDER_DATA_HEADER)) {
+        commit();
+    }
+    write_index();
+
+    // Update the header with the final size.
+    long pos = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    write_header();
+    fseek(file, pos, SEEK_SET);
+    fflush(file);
+
+    int ret = (rstats.errors == 0);
+    file = nullptr;
+    block.reset();
+    index.reset();
+    return ret;
+}
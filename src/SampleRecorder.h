@@ -0,0 +1,105 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SAMPLE_RECORDER_H__
+#define __SAMPLE_RECORDER_H__
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+enum {
+    AN_RECORDER_WAV     = 0U,   // 16-bit signed PCM wav file.
+    AN_RECORDER_CHUNKED = 1U,   // Raw samples in self-describing chunks, see below.
+};
+
+// All writes are multiples of the sector size, at sector aligned offsets.
+#define AN_RECORDER_SECTOR          (512)
+#define AN_RECORDER_VERSION         (1)
+#define AN_RECORDER_DATA_HEADER     (28)
+#define AN_RECORDER_INDEX_HEADER    (12)
+#define AN_RECORDER_INDEX_ENTRY     (16)
+
+// Chunked file layout (all fields little-endian uint32):
+//
+// File header (one sector): "AARC", version, sample rate, channels, resolution,
+// block size, index interval, index chunk size, total frames (low, high).
+//
+// Data chunk (block size bytes): "DATA", chunk size - 8, first frame (low, high),
+// timestamp, flags (DMA_BUFFER_DISCONT), valid sample bytes, samples.
+//
+// Index chunk (index chunk size bytes), written after every index interval data
+// chunks, and after the last one: "INDX", chunk size - 8, number of entries, and
+// per data chunk: first frame (low, high), timestamp, file offset.
+//
+// Since all chunks are fixed size, the offset of data chunk k is:
+//   SECTOR + k * block_size + (k / index_interval) * index_size
+
+struct RecorderStats {
+    uint32_t writes;        // Number of block writes.
+    uint32_t bytes;         // Total bytes written.
+    uint32_t min_us;        // Write latency.
+    uint32_t max_us;
+    uint32_t total_us;
+    uint32_t errors;        // Failed or short writes.
+};
+
+class SampleRecorder {
+    private:
+        FILE *file;
+        uint32_t format;
+        size_t block_size;
+        size_t index_interval;
+        size_t index_size;
+        size_t n_channels;
+        uint32_t resolution;
+        uint32_t sample_rate;
+        std::unique_ptr<uint8_t, decltype(&AlignedAlloc<__SCB_DCACHE_LINE_SIZE>::free)> block;
+        std::unique_ptr<uint32_t[]> index;
+        size_t n_index;
+        size_t offset;          // Write offset in block.
+        size_t capacity;        // Sample bytes per block.
+        uint64_t n_bytes;       // Total sample bytes recorded.
+        uint64_t frames;        // Total frames recorded.
+        uint64_t block_frame;   // First frame in the current block.
+        uint32_t block_ts;
+        uint32_t block_flags;
+        uint32_t file_offset;
+        RecorderStats rstats;
+
+        size_t write_block(size_t size);
+        void write_header();
+        void write_index();
+        void commit();
+
+    public:
+        SampleRecorder(size_t block_size=16384, size_t index_interval=64);
+        ~SampleRecorder();
+        int begin(FILE *file, uint32_t format, uint32_t sample_rate, size_t n_channels, uint32_t resolution);
+        size_t write(SampleBuffer buf);
+        int end();
+        uint64_t recorded() {
+            return frames;
+        }
+        const RecorderStats &stats() {
+            return rstats;
+        }
+};
+
+#endif  // __SAMPLE_RECORDER_H__
@@ -0,0 +1,301 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SampleReplay.h"
+
+static inline uint32_t get_le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+SampleReplay::~SampleReplay() {
+    stop();
+}
+
+int SampleReplay::open_wav() {
+    uint8_t hdr[16];
+    if (fread(hdr, 1, 12, file) != 12 || memcmp(&hdr[8], "WAVE", 4)) {
+        return 0;
+    }
+
+    // Walk the chunks until the data chunk, skipping any unknown ones.
+    n_channels = 0;
+    while (fread(hdr, 1, 8, file) == 8) {
+        uint32_t size = get_le32(&hdr[4]);
+        if (memcmp(hdr, "fmt ", 4) == 0) {
+            if (size < 16 || fread(hdr, 1, 16, file) != 16) {
+                return 0;
+            }
+            // Only 16-bit PCM is supported.
+            if (get_le16(&hdr[0]) != 1 || get_le16(&hdr[14]) != 16) {
+                return 0;
+            }
+            n_channels = get_le16(&hdr[2]);
+            sample_rate = get_le32(&hdr[4]);
+            size -= 16;
+        } else if (memcmp(hdr, "data", 4) == 0) {
+            if (n_channels == 0) {
+                return 0;
+            }
+            data_offset = ftell(file);
+            n_frames = size / (n_channels * sizeof(Sample));
+            adc_resolution = AN_RESOLUTION_16;
+            return 1;
+        }
+        fseek(file, size + (size & 1), SEEK_CUR);
+    }
+    return 0;
+}
+
+int SampleReplay::open_chunked() {
+    uint8_t hdr[40];
+    if (fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr) || memcmp(hdr, "AARC", 4)
+            || get_le32(&hdr[4]) != AN_RECORDER_VERSION) {
+        return 0;
+    }
+    sample_rate = get_le32(&hdr[8]);
+    n_channels = get_le32(&hdr[12]);
+    adc_resolution = get_le32(&hdr[16]);
+    block_size = get_le32(&hdr[20]);
+    index_interval = get_le32(&hdr[24]);
+    index_size = get_le32(&hdr[28]);
+    n_frames = get_le32(&hdr[32]) | ((uint64_t) get_le32(&hdr[36]) << 32);
+    if (n_channels == 0 || index_interval == 0 || block_size <= AN_RECORDER_DATA_HEADER) {
+        return 0;
+    }
+    chunk = 0;
+    chunk_left = 0;
+    return 1;
+}
+
+bool SampleReplay::next_chunk() {
+    // Chunks are fixed size, so the offset is computed instead of scanned.
+    uint32_t offset = AN_RECORDER_SECTOR + chunk * block_size + (chunk / index_interval) * index_size;
+    uint8_t hdr[AN_RECORDER_DATA_HEADER];
+    if (fseek(file, offset, SEEK_SET) || fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr)
+            || memcmp(hdr, "DATA", 4)) {
+        return false;
+    }
+    chunk_frame = get_le32(&hdr[8]) | ((uint64_t) get_le32(&hdr[12]) << 32);
+    chunk_ts = get_le32(&hdr[16]);
+    chunk_flags = get_le32(&hdr[20]);
+    chunk_left = get_le32(&hdr[24]);
+    chunk++;
+    return true;
+}
+
+int SampleReplay::seek_frame(uint64_t frame) {
+    if (frame > n_frames) {
+        return 0;
+    }
+
+    size_t frame_bytes = n_channels * sizeof(Sample);
+    if (format == AN_RECORDER_WAV) {
+        if (fseek(file, data_offset + frame * frame_bytes, SEEK_SET)) {
+            return 0;
+        }
+    } else {
+        size_t frames_per_chunk = (block_size - AN_RECORDER_DATA_HEADER) / frame_bytes;
+        chunk = frame / frames_per_chunk;
+        if (frame < n_frames) {
+            if (!next_chunk() || frame < chunk_frame) {
+                return 0;
+            }
+            size_t skip = (frame - chunk_frame) * frame_bytes;
+            fseek(file, skip, SEEK_CUR);
+            chunk_left -= skip;
+            chunk_flags = 0;
+        }
+    }
+    position = frame;
+    return 1;
+}
+
+size_t SampleReplay::read_samples(Sample *dst, size_t n, uint32_t *ts, uint32_t *flags) {
+    size_t count = 0;
+    *ts = (position * 1000) / sample_rate;
+    *flags = 0;
+
+    if (format == AN_RECORDER_WAV) {
+        // Stop at the end of the data chunk, any chunks after it aren't samples.
+        uint64_t left = (n_frames - position) * n_channels;
+        if (n > left) {
+            n = left;
+        }
+        count = fread(dst, sizeof(Sample), n, file);
+        // WAV samples are signed.
+        for (size_t i=0; i<count; i++) {
+            dst[i] ^= 0x8000;
+        }
+    } else {
+        while (count < n) {
+            if (chunk_left == 0 && !next_chunk()) {
+                break;
+            }
+            if (count == 0) {
+                // Chunk timestamp, plus the time of the frames already consumed.
+                size_t frames_in = position - chunk_frame;
+                *ts = chunk_ts + (frames_in * 1000) / sample_rate;
+            }
+            *flags |= chunk_flags;
+            chunk_flags = 0;
+            size_t len = (n - count) * sizeof(Sample);
+            if (len > chunk_left) {
+                len = chunk_left;
+            }
+            len = fread(&dst[count], 1, len, file);
+            if (len == 0) {
+                break;
+            }
+            chunk_left -= len;
+            count += len / sizeof(Sample);
+        }
+    }
+    position += count / n_channels;
+    return count;
+}
+
+bool SampleReplay::fill() {
+    while (!eof()) {
+        if (mode == AN_REPLAY_REALTIME) {
+            // Buffers become available when they'd have been completed by the ADC.
+            uint32_t due = start_us + (uint32_t) ((n_emitted * n_samples * 1000000ULL) / sample_rate);
+            if ((int32_t) (micros() - due) < 0) {
+                break;
+            }
+        }
+
+        if (!pool->writable()) {
+            if (mode == AN_REPLAY_FAST) {
+                break;
+            }
+            // The consumer is lagging, drop the samples just like the ADC would.
+            seek_frame(position + n_samples < n_frames ? position + n_samples : n_frames);
+            discont = true;
+            n_emitted++;
+            continue;
+        }
+
+        DMABuffer<Sample> *buf = pool->allocate();
+        uint32_t ts, flags;
+        if (read_samples(buf->data(), buf->size(), &ts, &flags) != buf->size()) {
+            // Drop the last partial buffer.
+            buf->release();
+            position = n_frames;
+            break;
+        }
+        buf->timestamp(ts);
+        if (discont || (flags & DMA_BUFFER_DISCONT)) {
+            buf->setflags(DMA_BUFFER_DISCONT);
+            discont = false;
+        }
+        if (n_channels > 1) {
+            buf->setflags(DMA_BUFFER_INTRLVD);
+        }
+        pool->enqueue(buf);
+        n_emitted++;
+    }
+    return pool->readable();
+}
+
+int SampleReplay::begin(FILE *file, size_t n_samples, size_t n_buffers, uint32_t mode) {
+    // Sanity checks.
+    if (file == nullptr || pool != nullptr || mode > AN_REPLAY_REALTIME) {
+        return 0;
+    }
+
+    this->file = file;
+    this->mode = mode;
+    this->n_samples = n_samples;
+    position = n_frames = 0;
+    sample_rate = 0;
+
+    uint8_t magic[4];
+    if (fread(magic, 1, 4, file) != 4) {
+        this->file = nullptr;
+        return 0;
+    }
+    fseek(file, 0, SEEK_SET);
+    format = memcmp(magic, "AARC", 4) ? AN_RECORDER_WAV : AN_RECORDER_CHUNKED;
+    if (!((format == AN_RECORDER_WAV) ? open_wav() : open_chunked()) || sample_rate == 0
+            || !seek_frame(0)) {
+        this->file = nullptr;
+        return 0;
+    }
+
+    // Allocate DMA buffer pool.
+    pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers);
+    if (pool == nullptr || !*pool) {
+        delete pool;
+        pool = nullptr;
+        this->file = nullptr;
+        return 0;
+    }
+
+    discont = false;
+    n_emitted = 0;
+    start_us = micros();
+    return 1;
+}
+
+bool SampleReplay::available() {
+    if (pool != nullptr) {
+        return pool->readable() || fill();
+    }
+    return false;
+}
+
+DMABuffer<Sample> &SampleReplay::read() {
+    static DMABuffer<Sample> NULLBUF;
+    if (pool != nullptr) {
+        while (!available()) {
+            if (eof()) {
+                return NULLBUF;
+            }
+        }
+        return *pool->dequeue();
+    }
+    return NULLBUF;
+}
+
+int SampleReplay::seek(uint64_t frame) {
+    if (pool == nullptr) {
+        return 0;
+    }
+    pool->flush();
+    if (!seek_frame(frame)) {
+        return 0;
+    }
+    // Restart the real-time clock from the new position.
+    n_emitted = 0;
+    start_us = micros();
+    return 1;
+}
+
+int SampleReplay::stop() {
+    if (pool) {
+        delete pool;
+    }
+    pool = nullptr;
+    file = nullptr;
+    return 1;
+}
@@ -0,0 +1,94 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SAMPLE_REPLAY_H__
+#define __SAMPLE_REPLAY_H__
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "SampleRecorder.h"
+
+enum {
+    AN_REPLAY_FAST      = 0U,   // As fast as the consumer reads, nothing is dropped.
+    AN_REPLAY_REALTIME  = 1U,   // At the recorded sample rate, drops buffers if the consumer lags.
+};
+
+// Feeds a capture written by SampleRecorder (wav or chunked) through the same
+// available()/read()/release() interface as AdvancedADC, so processing code
+// can be tested and benchmarked with reproducible input.
+class SampleReplay {
+    private:
+        FILE *file;
+        uint32_t format;
+        uint32_t mode;
+        size_t n_samples;
+        size_t n_channels;
+        uint32_t adc_resolution;
+        uint32_t sample_rate;
+        uint64_t n_frames;          // Total frames in file.
+        uint64_t position;          // Next frame to read.
+        DMABufferPool<Sample> *pool;
+        // WAV files.
+        uint32_t data_offset;
+        // Chunked files.
+        size_t block_size;
+        size_t index_interval;
+        size_t index_size;
+        size_t chunk;               // Current data chunk.
+        size_t chunk_left;          // Sample bytes left in the current data chunk.
+        uint32_t chunk_ts;
+        uint32_t chunk_flags;
+        uint64_t chunk_frame;
+        // Real-time pacing.
+        uint32_t start_us;
+        uint64_t n_emitted;
+        bool discont;
+
+        int open_wav();
+        int open_chunked();
+        bool next_chunk();
+        int seek_frame(uint64_t frame);
+        size_t read_samples(Sample *dst, size_t n, uint32_t *ts, uint32_t *flags);
+        bool fill();
+
+    public:
+        SampleReplay(): file(nullptr), n_frames(0), position(0), pool(nullptr) {
+        }
+        ~SampleReplay();
+        int begin(FILE *file, size_t n_samples, size_t n_buffers, uint32_t mode=AN_REPLAY_FAST);
+        bool available();
+        SampleBuffer read();
+        int seek(uint64_t frame);
+        int stop();
+        bool eof() {
+            return position >= n_frames;
+        }
+        size_t channels() {
+            return n_channels;
+        }
+        uint32_t rate() {
+            return sample_rate;
+        }
+        uint32_t resolution() {
+            return adc_resolution;
+        }
+};
+
+#endif  // __SAMPLE_REPLAY_H__
@@ -0,0 +1,187 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SAMPLE_STREAM_H__
+#define __SAMPLE_STREAM_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+// Reads samples from any buffer source with an AdvancedADC-like read() (e.g.
+// AdvancedADC, SampleReplay or SyntheticADC) as a continuous stream, hiding
+// buffer boundaries and buffer release. Windows that fit in one buffer are
+// returned without copying, windows that cross buffers are stitched in a
+// scratch buffer of max_window samples. Multi-channel samples are interleaved,
+// so windows should be a multiple of the number of channels.
+template <class S> class SampleStream {
+    private:
+        S &source;
+        DMABuffer<Sample> *buf;         // Current buffer.
+        size_t offset;                  // Next sample in the current buffer.
+        std::unique_ptr<Sample[]> scratch;
+        size_t max_window;
+        size_t sc_pos;                  // Next sample in the scratch buffer.
+        size_t sc_len;                  // Samples in the scratch buffer.
+        bool discont;
+
+        static size_t smaller(size_t a, size_t b) {
+            return (a < b) ? a : b;
+        }
+
+        size_t remaining() {
+            return buf ? (buf->size() - offset) : 0;
+        }
+
+        bool fetch() {
+            // Release the current buffer, and wait for the next one. Buffers are
+            // only released here, so spans returned by peek() and read() stay
+            // valid until the next call.
+            if (buf) {
+                buf->release();
+                buf = nullptr;
+            }
+            offset = 0;
+            DMABuffer<Sample> *next = &source.read();
+            if (!*next || next->size() == 0) {
+                // End of stream, or the source is stopped.
+                return false;
+            }
+            if (next->getflags(DMA_BUFFER_DISCONT)) {
+                discont = true;
+            }
+            buf = next;
+            return true;
+        }
+
+    public:
+        SampleStream(S &source, size_t max_window=0): source(source), buf(nullptr), offset(0),
+            scratch(max_window ? new Sample[max_window] : nullptr), max_window(scratch ? max_window : 0),
+            sc_pos(0), sc_len(0), discont(false) {
+        }
+
+        ~SampleStream() {
+            if (buf) {
+                buf->release();
+            }
+        }
+
+        size_t available() {
+            // Returns the number of samples that can be read without waiting.
+            if ((sc_len - sc_pos) == 0 && remaining() == 0 && source.available()) {
+                fetch();
+            }
+            return (sc_len - sc_pos) + remaining();
+        }
+
+        bool discontinuity() {
+            // Returns true if samples were dropped since the last call.
+            bool ret = discont;
+            discont = false;
+            return ret;
+        }
+
+        const Sample *peek(size_t n) {
+            // Returns a pointer to the next n samples without consuming them, or
+            // nullptr if the window doesn't fit in a buffer or the scratch buffer,
+            // or the stream ended. The pointer is valid until the next call.
+            if (n == 0) {
+                return nullptr;
+            }
+
+            if (sc_pos == sc_len) {
+                // Zero-copy path: no stitched samples pending.
+                sc_pos = sc_len = 0;
+                if (remaining() == 0 && !fetch()) {
+                    return nullptr;
+                }
+                if (remaining() >= n) {
+                    return buf->data() + offset;
+                }
+            }
+
+            if (n > max_window) {
+                return nullptr;
+            }
+
+            if ((sc_len - sc_pos) < n) {
+                // Stitch the window: move pending samples to the front of the
+                // scratch buffer, and copy only the missing samples.
+                memmove(&scratch[0], &scratch[sc_pos], (sc_len - sc_pos) * sizeof(Sample));
+                sc_len -= sc_pos;
+                sc_pos = 0;
+                while (sc_len < n) {
+                    if (remaining() == 0 && !fetch()) {
+                        return nullptr;
+                    }
+                    size_t count = smaller(n - sc_len, remaining());
+                    memcpy(&scratch[sc_len], buf->data() + offset, count * sizeof(Sample));
+                    sc_len += count;
+                    offset += count;
+                }
+            }
+            return &scratch[sc_pos];
+        }
+
+        size_t skip(size_t n) {
+            // Discards n samples, returns the number of samples skipped.
+            size_t count = smaller(n, sc_len - sc_pos);
+            sc_pos += count;
+            while (count < n) {
+                if (remaining() == 0 && !fetch()) {
+                    break;
+                }
+                size_t len = smaller(n - count, remaining());
+                offset += len;
+                count += len;
+            }
+            return count;
+        }
+
+        const Sample *read(size_t n) {
+            // Same as peek(), and consumes the samples.
+            const Sample *ptr = peek(n);
+            if (ptr != nullptr) {
+                skip(n);
+            }
+            return ptr;
+        }
+
+        size_t read(Sample *dst, size_t n) {
+            // Copies the next n samples to dst, waiting for buffers as needed.
+            // Returns the number of samples copied, less than n only if the
+            // stream ended.
+            size_t count = smaller(n, sc_len - sc_pos);
+            if (count) {
+                memcpy(dst, &scratch[sc_pos], count * sizeof(Sample));
+                sc_pos += count;
+            }
+            while (count < n) {
+                if (remaining() == 0 && !fetch()) {
+                    break;
+                }
+                size_t len = smaller(n - count, remaining());
+                memcpy(dst + count, buf->data() + offset, len * sizeof(Sample));
+                offset += len;
+                count += len;
+            }
+            return count;
+        }
+};
+
+#endif  // __SAMPLE_STREAM_H__
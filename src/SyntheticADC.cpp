@@ -0,0 +1,208 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "SyntheticADC.h"
+
+static const uint8_t ADC_BITS_LUT[] = {
+    8, 10, 12, 14, 16,
+};
+
+SyntheticADC::SyntheticADC(size_t n_channels):
+    n_channels(n_channels), sample_rate(0), n_buffers(0), mode(AN_SYNTHETIC_REALTIME), max_value(0), pool(nullptr),
+    dmabuf{nullptr, nullptr}, ct(0), start_us(0), n_completed(0), n_dropped(0), rng(0x2545F491) {
+    if (this->n_channels > AN_MAX_ADC_CHANNELS) {
+        this->n_channels = AN_MAX_ADC_CHANNELS;
+    }
+    for (size_t i=0; i<AN_MAX_ADC_CHANNELS; i++) {
+        signals[i] = {AN_SIGNAL_DC, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f};
+    }
+}
+
+SyntheticADC::~SyntheticADC() {
+    stop();
+}
+
+int SyntheticADC::signal(size_t channel, uint32_t type, float frequency, float amplitude, float offset, float param) {
+    if (channel >= n_channels || type > AN_SIGNAL_STEP) {
+        return 0;
+    }
+    signals[channel] = {type, frequency, amplitude, offset, param, 0.0f, 0.0f};
+    return 1;
+}
+
+float SyntheticADC::next(signal_descr_t *sig) {
+    float dt = 1.0f / sample_rate;
+    float v = 0.0f;
+
+    switch (sig->type) {
+        case AN_SIGNAL_SINE:
+            v = sinf(2.0f * PI * sig->phase);
+            sig->phase += sig->frequency * dt;
+            break;
+        case AN_SIGNAL_CHIRP:
+            // Instantaneous frequency sweeps linearly over one second.
+            v = sinf(2.0f * PI * sig->phase);
+            sig->phase += (sig->frequency + (sig->param - sig->frequency) * sig->t) * dt;
+            sig->t += dt;
+            if (sig->t >= 1.0f) {
+                sig->t = 0.0f;
+            }
+            break;
+        case AN_SIGNAL_NOISE:
+            // xorshift32
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            v = (rng / 2147483648.0f) - 1.0f;
+            break;
+        case AN_SIGNAL_STEP:
+            v = (sig->phase < 0.5f) ? -1.0f : 1.0f;
+            sig->phase += sig->frequency * dt;
+            break;
+    }
+    if (sig->phase >= 1.0f) {
+        sig->phase -= (int) sig->phase;
+    }
+
+    v = sig->offset + sig->amplitude * v;
+    if (v < 0.0f) {
+        v = 0.0f;
+    } else if (v > 1.0f) {
+        v = 1.0f;
+    }
+    return v;
+}
+
+void SyntheticADC::transfer(DMABuffer<Sample> *buf) {
+    // What the DMA would write: one sample per channel, per trigger.
+    Sample *dst = buf->data();
+    for (size_t i=0; i<buf->size(); i+=n_channels) {
+        for (size_t c=0; c<n_channels; c++) {
+            dst[i + c] = (Sample) (next(&signals[c]) * max_value + 0.5f);
+        }
+    }
+}
+
+void SyntheticADC::complete() {
+    // Same as the ADC transfer complete interrupt.
+    transfer(dmabuf[ct]);
+    dmabuf[ct]->timestamp(millis());
+
+    if (pool->writable()) {
+        pool->enqueue(dmabuf[ct]);
+        dmabuf[ct] = pool->allocate();
+        if (dmabuf[ct]->channels() > 1) {
+            dmabuf[ct]->setflags(DMA_BUFFER_INTRLVD);
+        }
+    } else {
+        dmabuf[ct]->setflags(DMA_BUFFER_DISCONT);
+        n_dropped++;
+    }
+    ct = !ct;
+    n_completed++;
+}
+
+int SyntheticADC::begin(uint32_t resolution, uint32_t sample_rate, size_t n_samples, size_t n_buffers, uint32_t mode) {
+    // Sanity checks.
+    if (resolution >= AN_ARRAY_SIZE(ADC_BITS_LUT) || sample_rate == 0 || n_channels == 0
+            || mode > AN_SYNTHETIC_REALTIME || pool != nullptr) {
+        return 0;
+    }
+
+    // Allocate DMA buffer pool.
+    pool = new DMABufferPool<Sample>(n_samples, n_channels, n_buffers);
+    if (pool == nullptr || !*pool || n_buffers < 2) {
+        stop();
+        return 0;
+    }
+    dmabuf[0] = pool->allocate();
+    dmabuf[1] = pool->allocate();
+    for (size_t i=0; i<AN_ARRAY_SIZE(dmabuf); i++) {
+        if (dmabuf[i]->channels() > 1) {
+            dmabuf[i]->setflags(DMA_BUFFER_INTRLVD);
+        }
+    }
+
+    this->sample_rate = sample_rate;
+    this->n_buffers = n_buffers;
+    this->mode = mode;
+    max_value = (1UL << ADC_BITS_LUT[resolution]) - 1;
+    ct = 0;
+    n_completed = 0;
+    n_dropped = 0;
+    start_us = micros();
+    return 1;
+}
+
+bool SyntheticADC::available() {
+    if (pool == nullptr) {
+        return false;
+    }
+
+    if (mode == AN_SYNTHETIC_FAST) {
+        if (!pool->readable() && pool->writable()) {
+            complete();
+        }
+    } else {
+        // Run the transfer completions that are due by now, at most one pool's worth.
+        size_t n_samples = dmabuf[0]->size() / n_channels;
+        for (size_t i=0; ; i++) {
+            uint32_t due = start_us + (uint32_t) (((n_completed + 1) * n_samples * 1000000ULL) / sample_rate);
+            int32_t late = micros() - due;
+            if (late < 0) {
+                break;
+            }
+            if (i == n_buffers) {
+                // Synthesizing is slower than real time: skip the missed buffers,
+                // like an ADC with a stalled consumer, and restart the schedule.
+                uint32_t period = (n_samples * 1000000ULL) / sample_rate;
+                n_dropped += late / (period ? period : 1) + 1;
+                start_us = micros() - (uint32_t) ((n_completed * n_samples * 1000000ULL) / sample_rate);
+                dmabuf[ct]->setflags(DMA_BUFFER_DISCONT);
+                break;
+            }
+            complete();
+        }
+    }
+    return pool->readable();
+}
+
+DMABuffer<Sample> &SyntheticADC::read() {
+    static DMABuffer<Sample> NULLBUF;
+    if (pool != nullptr) {
+        while (!available()) {
+        }
+        return *pool->dequeue();
+    }
+    return NULLBUF;
+}
+
+int SyntheticADC::stop() {
+    for (size_t i=0; i<AN_ARRAY_SIZE(dmabuf); i++) {
+        if (dmabuf[i]) {
+            dmabuf[i]->release();
+            dmabuf[i] = nullptr;
+        }
+    }
+    if (pool) {
+        delete pool;
+    }
+    pool = nullptr;
+    return 1;
+}
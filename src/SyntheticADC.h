@@ -0,0 +1,93 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SYNTHETIC_ADC_H__
+#define __SYNTHETIC_ADC_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+
+enum {
+    AN_SYNTHETIC_FAST       = 0U,   // A buffer is completed whenever the consumer asks for one.
+    AN_SYNTHETIC_REALTIME   = 1U,   // Buffers are completed at the sample rate.
+};
+
+enum {
+    AN_SIGNAL_DC        = 0U,
+    AN_SIGNAL_SINE      = 1U,
+    AN_SIGNAL_CHIRP     = 2U,   // Linear sweep from frequency to param Hz, every second.
+    AN_SIGNAL_NOISE     = 3U,   // Uniform white noise.
+    AN_SIGNAL_STEP      = 4U,   // Square wave.
+};
+
+struct signal_descr_t {
+    uint32_t type;
+    float frequency;
+    float amplitude;
+    float offset;
+    float param;
+    float phase;
+    float t;
+};
+
+// Synthetic source with the same interface as AdvancedADC. Buffers are filled
+// and completed by a simulation of the ADC DMA double-buffering and transfer
+// complete interrupt, either paced at the sample rate (AN_SYNTHETIC_REALTIME),
+// or as fast as the consumer reads (AN_SYNTHETIC_FAST). In real time, if synthesizing
+// falls behind, the missed buffers are skipped and the next one is flagged
+// DMA_BUFFER_DISCONT. Amplitude and offset are fractions of full scale.
+class SyntheticADC {
+    private:
+        size_t n_channels;
+        uint32_t sample_rate;
+        size_t n_buffers;
+        uint32_t mode;
+        uint32_t max_value;
+        DMABufferPool<Sample> *pool;
+        DMABuffer<Sample> *dmabuf[2];
+        size_t ct;
+        uint32_t start_us;
+        uint64_t n_completed;
+        uint32_t n_dropped;
+        uint32_t rng;
+        signal_descr_t signals[AN_MAX_ADC_CHANNELS];
+
+        float next(signal_descr_t *sig);
+        void transfer(DMABuffer<Sample> *buf);
+        void complete();
+
+    public:
+        SyntheticADC(size_t n_channels=1);
+        ~SyntheticADC();
+        int signal(size_t channel, uint32_t type, float frequency=0.0f, float amplitude=0.5f,
+                float offset=0.5f, float param=0.0f);
+        int begin(uint32_t resolution, uint32_t sample_rate, size_t n_samples, size_t n_buffers,
+                uint32_t mode=AN_SYNTHETIC_REALTIME);
+        bool available();
+        SampleBuffer read();
+        int stop();
+        uint64_t completed() {
+            return n_completed;
+        }
+        uint32_t dropped() {
+            return n_dropped;
+        }
+};
+
+#endif  // __SYNTHETIC_ADC_H__
@@ -0,0 +1,97 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "VrefCorrection.h"
+
+static uint32_t ADC_BITS_LUT[] = {8, 10, 12, 14, 16};
+
+int VrefCorrection::begin(uint32_t resolution, int vref_channel, int temp_channel) {
+    // Channels are indices in the scan sequence, temp_channel is -1 if unused.
+    if (resolution >= AN_ARRAY_SIZE(ADC_BITS_LUT) || vref_channel < 0 || vref_channel >= AN_MAX_ADC_CHANNELS
+     || temp_channel >= AN_MAX_ADC_CHANNELS || temp_channel == vref_channel) {
+        return 0;
+    }
+    this->bits = ADC_BITS_LUT[resolution];
+    this->vref_channel = vref_channel;
+    this->temp_channel = temp_channel;
+    ratio = 1 << 15;
+    temp = 0.0f;
+    return 1;
+}
+
+void VrefCorrection::compute(SampleBuffer buf) {
+    size_t n_channels = buf.channels();
+    size_t n_frames = buf.size() / (n_channels ? n_channels : 1);
+    if (vref_channel < 0 || (size_t) vref_channel >= n_channels || n_frames == 0) {
+        return;
+    }
+
+    Sample *data = buf.data();
+    // 16-bit samples summed over more than 65536 frames overflow 32 bits.
+    uint64_t vref = 0, ts = 0;
+    for (size_t i=0; i<n_frames; i++) {
+        vref += data[i * n_channels + vref_channel];
+        if (temp_channel >= 0) {
+            ts += data[i * n_channels + temp_channel];
+        }
+    }
+
+    // The calibration values were taken at 16 bits.
+    vref = (vref << (16 - bits)) / n_frames;
+    if (vref == 0) {
+        // Keep the last ratio.
+        return;
+    }
+    ratio = ((uint32_t) *VREFINT_CAL_ADDR << 15) / vref;
+    if (ratio >= (2 << 15)) {
+        ratio = (2 << 15) - 1;
+    }
+
+    if (temp_channel >= 0 && (size_t) temp_channel < n_channels) {
+        // Linear interpolation between the two calibration points, after
+        // referring the reading to the calibration supply.
+        float ts_data = (float) (ts << (16 - bits)) / n_frames;
+        ts_data = ts_data * ratio / (1 << 15) * VREFINT_CAL_VREF / TEMPSENSOR_CAL_VREFANALOG;
+        temp = (float) (TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP) * (ts_data - *TEMPSENSOR_CAL1_ADDR)
+             / (int32_t) (*TEMPSENSOR_CAL2_ADDR - *TEMPSENSOR_CAL1_ADDR) + TEMPSENSOR_CAL1_TEMP;
+    }
+
+    // The product fits in 32 bits, since both factors are below 2^16.
+    uint32_t max = (1 << bits) - 1;
+    for (size_t i=0; i<n_frames; i++) {
+        for (size_t c=0; c<n_channels; c++) {
+            if ((int) c == vref_channel || (int) c == temp_channel) {
+                continue;
+            }
+            uint32_t y = (data[i * n_channels + c] * ratio + (1 << 14)) >> 15;
+            data[i * n_channels + c] = (y > max) ? max : y;
+        }
+    }
+}
+
+float VrefCorrection::vdda() {
+    // Returns the supply voltage measured in the last buffer, in volts.
+    return (float) ratio / (1 << 15) * VREFINT_CAL_VREF / 1000.0f;
+}
+
+float VrefCorrection::temperature() {
+    // Returns the die temperature measured in the last buffer, in degrees C.
+    return temp;
+}
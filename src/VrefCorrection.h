@@ -0,0 +1,54 @@
+/*
+  This file is part of the Arduino_AdvancedAnalog library.
+  Copyright (c) 2023 Arduino SA. All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __VREF_CORRECTION_H__
+#define __VREF_CORRECTION_H__
+
+#include "Arduino.h"
+#include "AdvancedAnalog.h"
+#include "Pipeline.h"
+
+// Ratiometric correction of the ADC's supply, in place over interleaved buffers
+// which include a VREFINT channel (see AN_ADC_VREFINT). The mean VREFINT reading
+// of each buffer is compared to its factory calibration, taken with VDDA at
+// VREFINT_CAL_VREF, and every other channel is rescaled by the ratio so readings
+// are relative to that nominal supply, whatever VDDA actually is. The VREFINT
+// and temperature channels are left untouched.
+class VrefCorrection : public PipelineStage {
+    private:
+        uint32_t bits;
+        int vref_channel;
+        int temp_channel;
+        uint32_t ratio;     // VDDA / VREFINT_CAL_VREF of the last buffer, Q15.
+        float temp;
+
+    public:
+        VrefCorrection(): bits(16), vref_channel(-1), temp_channel(-1), ratio(1 << 15), temp(0.0f) {
+        }
+        int begin(uint32_t resolution, int vref_channel, int temp_channel=-1);
+        void compute(SampleBuffer buf);
+        DMABuffer<Sample> *process(DMABuffer<Sample> *buf) override {
+            compute(*buf);
+            return buf;
+        }
+        float vdda();
+        float temperature();
+};
+
+#endif  // __VREF_CORRECTION_H__